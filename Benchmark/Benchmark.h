@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+namespace Benchmark
+{
+
+/**
+ * Keeps results alive so the measured work isn't optimized away
+ */
+extern volatile double sink;
+
+/**
+ * Set by benchmarks that saw the library misbehave, the run then exits with a failure
+ */
+extern bool failed;
+
+/**
+ * Runs func iterations times and returns the average wall time of a single call in nanoseconds
+ */
+template <typename Func>
+double NanosPerCall(size_t iterations, Func func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        func();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(elapsed).count() / iterations;
+}
+
+inline void Report(const char *name, double nanos, const char *unit = "draw")
+{
+    std::printf("  %-44s %10.2f ns/%s\n", name, nanos, unit);
+}
+
+// Benchmarks, each prints its own results
+void RandomBenchmark();
+void PlanBenchmark();
+void PlaybackBenchmark();
+void SimulatorBenchmark();
+void X11Benchmark();
+void InterferenceBenchmark();
+
+} // namespace Benchmark
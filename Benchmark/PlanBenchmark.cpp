@@ -0,0 +1,50 @@
+#include "Benchmark.h"
+#include "DefaultNature.h"
+#include "StepKernel.h"
+
+using namespace NaturalMouseMotion;
+
+namespace Benchmark
+{
+
+static constexpr size_t PLANS = 20000;
+
+template <typename Nature>
+static void setDefaults(Nature &nature)
+{
+    nature.info_printer = nullptr;
+    nature.debug_printer = nullptr;
+    nature.observer = nullptr;
+    nature.random = RandomStream{DefaultProvider::FastRandomProvider(42)};
+    nature.timeToStepsDivider = DefaultProvider::TIME_TO_STEPS_DIVIDER;
+    nature.minSteps = DefaultProvider::MIN_STEPS;
+    nature.effectFadeSteps = DefaultProvider::EFFECT_FADE_STEPS;
+}
+
+template <typename Nature>
+static double nanosPerStep(Nature &nature)
+{
+    static Flow flow{FlowTemplates::variatingFlow()};
+    Movement movement(1500, 900, std::hypot(1400, 800), 1400, 800, 1000, &flow);
+    MovementSteps steps;
+    auto count = StepKernel::StepsFor(nature, movement);
+    return NanosPerCall(PLANS, [&]() {
+        StepKernel::Plan(nature, movement, {100, 100}, {1920, 1080}, steps);
+        sink = sink + steps.x[count - 1];
+    }) / count;
+}
+
+void PlanBenchmark()
+{
+    MotionNature erased;
+    setDefaults(erased);
+    erased.getDeviation = GetDeviationFunc{DefaultProvider::SinusoidalDeviationProvider()};
+    erased.getNoise = GetNoiseFunc{DefaultProvider::DefaultNoiseProvider()};
+    Report("MotionNature StepKernel::Plan", nanosPerStep(erased), "step");
+
+    InlineMotionNature inlined;
+    setDefaults(inlined);
+    Report("InlineMotionNature StepKernel::Plan", nanosPerStep(inlined), "step");
+}
+
+} // namespace Benchmark
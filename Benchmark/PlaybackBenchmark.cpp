@@ -0,0 +1,100 @@
+#include "Benchmark.h"
+#include "NaturalMouseMotion.h"
+
+using namespace NaturalMouseMotion;
+
+namespace Benchmark
+{
+
+// Real clock and sleeps, but the cursor isn't moved
+struct ClockOnlySystemCalls : public SystemCalls
+{
+    Point<int> position{0, 0};
+
+    time_type currentTimeMillis() override
+    {
+        return DefaultProvider::SteadyClock::Nanos() / NANOS_IN_MILLI;
+    }
+    void sleep(time_type time) override
+    {
+        DefaultProvider::SteadyClock::SleepNanos(time * NANOS_IN_MILLI);
+    }
+    Dimension getScreenSize() override
+    {
+        return {1920, 1080};
+    }
+    void setMousePosition(int x, int y) override
+    {
+        position = {x, y};
+    }
+    Point<int> getMousePosition() override
+    {
+        return position;
+    }
+    time_type currentTimeNanos() override
+    {
+        return DefaultProvider::SteadyClock::Nanos();
+    }
+    void sleepNanos(time_type nanos) override
+    {
+        DefaultProvider::SteadyClock::SleepNanos(nanos);
+    }
+    void sleepUntilNanos(time_type deadline) override
+    {
+        DefaultProvider::SteadyClock::SleepUntilNanos(deadline);
+    }
+};
+
+static void play(const char *name, const RealtimeConfig &realtime)
+{
+    MotionNature nature;
+    nature.info_printer = nullptr;
+    nature.debug_printer = nullptr;
+    nature.observer = nullptr;
+    nature.random = RandomStream{DefaultProvider::FastRandomProvider(42)};
+    nature.timeToStepsDivider = DefaultProvider::TIME_TO_STEPS_DIVIDER;
+    nature.minSteps = DefaultProvider::MIN_STEPS;
+    nature.effectFadeSteps = DefaultProvider::EFFECT_FADE_STEPS;
+    nature.reactionTimeBaseMs = DefaultProvider::REACTION_TIME_BASE_MS;
+    nature.reactionTimeVariationMs = DefaultProvider::REACTION_TIME_VARIATION_MS;
+    nature.getDeviation = GetDeviationFunc{DefaultProvider::SinusoidalDeviationProvider()};
+    nature.getNoise = GetNoiseFunc{DefaultProvider::DefaultNoiseProvider()};
+    auto overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(nature.random);
+    overshootManager->overshoots = 0;
+    nature.overshootManager = overshootManager;
+    nature.getFlowWithTime = [](double) -> std::pair<const Flow *, time_type> {
+        static Flow flow{FlowTemplates::variatingFlow()};
+        return {&flow, 400};
+    };
+    nature.systemCalls = std::make_shared<ClockOnlySystemCalls>();
+    nature.realtime = realtime;
+    nature.stats = std::make_shared<PlaybackStats>();
+
+    for (int i = 0; i < 5; i++)
+    {
+        Move(nature, i % 2 ? 100 : 1800, i % 2 ? 100 : 1000);
+    }
+
+    auto &stats = *nature.stats;
+    std::printf("%s, %d real-time settings failed\n", name, (int)stats.realtime.failures);
+    Report("step lateness p50", stats.stepLateness.p50(), "step");
+    Report("step lateness p99", stats.stepLateness.p99(), "step");
+    Report("step lateness max", stats.stepLateness.max(), "step");
+    Report("oversleep p99", stats.oversleep.p99(), "sleep");
+    Report("actual - planned", (stats.actualNanos - stats.plannedNanos) / 5.0, "move");
+}
+
+void PlaybackBenchmark()
+{
+    play("Default thread", RealtimeConfig{});
+
+    RealtimeConfig realtime;
+    realtime.scheduling = RealtimeConfig::Scheduling::Fifo;
+    realtime.priority = 50;
+    realtime.cpu = 0;
+    realtime.lockMemory = true;
+    realtime.minimalTimerSlack = true;
+    play("Real-time thread", realtime);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,36 @@
+#include "Benchmark.h"
+#include "DefaultProvider.h"
+
+using namespace NaturalMouseMotion;
+
+namespace Benchmark
+{
+
+static constexpr size_t DRAWS = 10000000;
+static constexpr size_t BATCH = 256;
+
+template <typename Provider>
+static void measure(const char *name, Provider provider)
+{
+    std::printf("%s\n", name);
+
+    Report("direct call", NanosPerCall(DRAWS, [&]() { sink = sink + provider(); }));
+
+    auto stream = RandomStream{provider};
+    Report("RandomStream call", NanosPerCall(DRAWS, [&]() { sink = sink + stream(); }));
+
+    double values[BATCH];
+    Report("RandomStream fill", NanosPerCall(DRAWS / BATCH, [&]() {
+        stream.fill(values, BATCH);
+        sink = sink + values[BATCH - 1];
+    }) / BATCH);
+}
+
+void RandomBenchmark()
+{
+    measure("DefaultRandomProvider (mt19937)", DefaultProvider::DefaultRandomProvider());
+    measure("FastRandomProvider (xoshiro256++)", DefaultProvider::FastRandomProvider());
+    measure("CounterRandomProvider (Philox4x32-10)", DefaultProvider::CounterRandomProvider(42));
+}
+
+} // namespace Benchmark
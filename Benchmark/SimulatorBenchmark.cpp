@@ -0,0 +1,92 @@
+#include <thread>
+#include <vector>
+#include "Benchmark.h"
+#include "NaturalMouseMotion.h"
+
+using namespace NaturalMouseMotion;
+
+namespace Benchmark
+{
+
+// Sink of a simulated pointer, the cursor isn't moved
+struct PointerSinkSystemCalls : public SystemCalls
+{
+    Point<int> position{0, 0};
+
+    time_type currentTimeMillis() override
+    {
+        return 0;
+    }
+    void sleep(time_type /* time */) override
+    {
+    }
+    Dimension getScreenSize() override
+    {
+        return {1920, 1080};
+    }
+    void setMousePosition(int x, int y) override
+    {
+        position = {x, y};
+    }
+    Point<int> getMousePosition() override
+    {
+        return position;
+    }
+};
+
+static MotionNature NewPointerNature(uint64_t seed)
+{
+    MotionNature nature;
+    nature.info_printer = nullptr;
+    nature.debug_printer = nullptr;
+    nature.observer = nullptr;
+    nature.random = RandomStream{DefaultProvider::FastRandomProvider(seed)};
+    nature.timeToStepsDivider = DefaultProvider::TIME_TO_STEPS_DIVIDER;
+    nature.minSteps = DefaultProvider::MIN_STEPS;
+    nature.effectFadeSteps = DefaultProvider::EFFECT_FADE_STEPS;
+    nature.reactionTimeBaseMs = DefaultProvider::REACTION_TIME_BASE_MS;
+    nature.reactionTimeVariationMs = DefaultProvider::REACTION_TIME_VARIATION_MS;
+    nature.getDeviation = GetDeviationFunc{DefaultProvider::SinusoidalDeviationProvider()};
+    nature.getNoise = GetNoiseFunc{DefaultProvider::DefaultNoiseProvider()};
+    nature.overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(nature.random);
+    nature.getFlowWithTime = [](double distance) -> std::pair<const Flow *, time_type> {
+        static Flow flow{FlowTemplates::variatingFlow()};
+        return {&flow, 200 + (time_type)distance / 2};
+    };
+    nature.systemCalls = std::make_shared<PointerSinkSystemCalls>();
+    return nature;
+}
+
+static void simulate(int pointerCount, int threads)
+{
+    std::vector<MotionNature> natures;
+    natures.reserve(pointerCount);
+    MotionSimulator::Options options;
+    options.threads = threads;
+    MotionSimulator simulator(options);
+    for (int i = 0; i < pointerCount; i++)
+    {
+        natures.push_back(NewPointerNature(i + 1));
+        std::vector<Point<int>> targets;
+        for (int j = 0; j < 5; j++)
+        {
+            targets.push_back({(i * 37 + j * 401) % 1920, (i * 53 + j * 211) % 1080});
+        }
+        simulator.addPointer(natures.back(), targets);
+    }
+
+    auto report = simulator.run();
+    std::printf("%d pointers on %d threads, %llu moves, %llu steps\n", pointerCount, threads, (unsigned long long)report.moves, (unsigned long long)report.steps);
+    Report("wall time per step", report.steps > 0 ? report.wallNanos / (double)report.steps : 0, "step");
+    std::printf("  %-44s %10.0f steps/s\n", "simulated steps", report.stepsPerSecond());
+    std::printf("  %-44s %10.1f x\n", "faster than real time", report.speedup());
+}
+
+void SimulatorBenchmark()
+{
+    auto threads = std::max(1, (int)std::thread::hardware_concurrency());
+    simulate(10000, 1);
+    simulate(10000, threads);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,203 @@
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+#include "Benchmark.h"
+#include "NaturalMouseMotion.h"
+
+using namespace NaturalMouseMotion;
+
+namespace Benchmark
+{
+
+#ifdef __linux__
+
+// Counts the pointer queries, each of them a round-trip to the X server
+struct QueryCountingSystemCalls : public SystemCalls
+{
+    SystemCalls &inner;
+    uint64_t queries{0};
+
+    explicit QueryCountingSystemCalls(SystemCalls &inner) : inner(inner)
+    {
+    }
+
+    time_type currentTimeMillis() override
+    {
+        return inner.currentTimeMillis();
+    }
+    void sleep(time_type time) override
+    {
+        inner.sleep(time);
+    }
+    Dimension getScreenSize() override
+    {
+        return inner.getScreenSize();
+    }
+    void setMousePosition(int x, int y) override
+    {
+        inner.setMousePosition(x, y);
+    }
+    Point<int> getMousePosition() override
+    {
+        queries++;
+        return inner.getMousePosition();
+    }
+    time_type currentTimeNanos() override
+    {
+        return inner.currentTimeNanos();
+    }
+    void sleepNanos(time_type nanos) override
+    {
+        inner.sleepNanos(nanos);
+    }
+    void sleepUntilNanos(time_type deadline) override
+    {
+        inner.sleepUntilNanos(deadline);
+    }
+};
+
+static time_type CpuNanos()
+{
+    timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return static_cast<time_type>(now.tv_sec) * 1000 * NANOS_IN_MILLI + now.tv_nsec;
+}
+
+template <typename Backend>
+static void play(const char *name)
+{
+    const int moves = 10;
+    Backend backend;
+    // Waits don't spin, so the CPU time is what talking to the server costs
+    backend.spinNanos = 0;
+    auto systemCalls = std::make_shared<QueryCountingSystemCalls>(backend);
+
+    auto nature = DefaultNature::NewFastGamerNature();
+    nature.info_printer = nullptr;
+    nature.debug_printer = nullptr;
+    nature.systemCalls = systemCalls;
+    nature.stats = std::make_shared<PlaybackStats>();
+    auto screenSize = backend.getScreenSize();
+    auto monitors = backend.getScreenLayout()->getMonitors().size();
+
+    XSync(backend.display, False);
+    auto requestsBefore = XNextRequest(backend.display);
+    auto cpuBefore = CpuNanos();
+    for (int i = 0; i < moves; i++)
+    {
+        Move(nature, i % 2 ? screenSize.Width / 10 : screenSize.Width * 9 / 10, i % 2 ? screenSize.Height / 10 : screenSize.Height * 9 / 10);
+    }
+    auto cpu = CpuNanos() - cpuBefore;
+    auto requests = XNextRequest(backend.display) - requestsBefore;
+    XSync(backend.display, False);
+
+    auto &stats = *nature.stats;
+    std::printf("%s, %llu steps in %d moves on %zu monitors\n", name, (unsigned long long)stats.emittedSteps, moves, monitors);
+    // Checked after the last move only, a query per move would add to what is measured
+    auto position = backend.getMousePosition();
+    Point<int> target{screenSize.Width / 10, screenSize.Height / 10};
+    if (position.x != target.x || position.y != target.y || monitors == 0)
+    {
+        std::printf("  FAILED, cursor at (%d, %d) instead of (%d, %d)\n", position.x, position.y, target.x, target.y);
+        failed = true;
+    }
+    Report("CPU", cpu / (double)moves, "move");
+    Report("CPU", cpu / (double)stats.emittedSteps, "step");
+    std::printf("  %-44s %10.1f /move\n", "requests", requests / (double)moves);
+    std::printf("  %-44s %10.1f /move\n", "round-trips (pointer queries)", systemCalls->queries / (double)moves);
+    Report("setMousePosition p50", stats.setMousePositionTime.p50(), "call");
+    Report("setMousePosition p99", stats.setMousePositionTime.p99(), "call");
+    Report("step lateness p99", stats.stepLateness.p99(), "step");
+    Report("time to first step p50", stats.timeToFirstStep.p50(), "move");
+    Report("time to first step p99", stats.timeToFirstStep.p99(), "move");
+}
+
+#if defined(NATURAL_MOUSE_MOTION_XINPUT2) && defined(NATURAL_MOUSE_MOTION_XTEST)
+// Time from a motion of the user until an aborting Move has returned, the user being XTest on a connection of its own
+static void interference()
+{
+    const int trials = 20;
+    Display *user = XOpenDisplay(nullptr);
+    LatencyHistogram latency;
+    int completed = 0;
+    for (int i = 0; i < trials; i++)
+    {
+        auto nature = DefaultNature::NewAverageComputerUserNature();
+        nature.info_printer = nullptr;
+        nature.debug_printer = nullptr;
+        nature.onInterference = InterferencePolicy::Abort;
+        auto screenSize = nature.systemCalls->getScreenSize();
+        Point<int> target{i % 2 ? screenSize.Width / 10 : screenSize.Width * 9 / 10, screenSize.Height / 2};
+        std::atomic<time_type> returned{0};
+        std::thread mover([&]() {
+            Move(nature, target.x, target.y);
+            returned.store(DefaultProvider::SteadyClock::Nanos());
+        });
+        // well within the movement
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto moved = DefaultProvider::SteadyClock::Nanos();
+        XTestFakeRelativeMotionEvent(user, 3, 3, CurrentTime);
+        XFlush(user);
+        mover.join();
+        latency.add(returned.load() - moved);
+        auto position = nature.systemCalls->getMousePosition();
+        completed += position.x == target.x && position.y == target.y;
+    }
+    XCloseDisplay(user);
+
+    std::printf("Interference, DefaultSystemCalls with XInput2 raw motion, %d moves\n", trials);
+    if (completed > 0)
+    {
+        std::printf("  FAILED, %d of the moves weren't aborted\n", completed);
+        failed = true;
+    }
+    Report("user motion until Move returned p50", latency.p50(), "move");
+    Report("user motion until Move returned p99", latency.p99(), "move");
+}
+#endif
+
+void X11Benchmark()
+{
+    if (!std::getenv("DISPLAY"))
+    {
+        std::printf("Skipped, needs an X server in DISPLAY, e.g. Xvfb :99 & DISPLAY=:99 %s x11\n", "NaturalMouseMotion_benchmark");
+        return;
+    }
+    play<DefaultProvider::DefaultSystemCalls>("DefaultSystemCalls (XWarpPointer)");
+#ifdef NATURAL_MOUSE_MOTION_XTEST
+    play<DefaultProvider::XTestSystemCalls>("XTestSystemCalls");
+#else
+    std::printf("XTestSystemCalls not built, libXtst wasn't found\n");
+#endif
+}
+
+void InterferenceBenchmark()
+{
+    if (!std::getenv("DISPLAY"))
+    {
+        std::printf("Skipped, needs an X server in DISPLAY, e.g. Xvfb :99 & DISPLAY=:99 %s interference\n", "NaturalMouseMotion_benchmark");
+        return;
+    }
+#if defined(NATURAL_MOUSE_MOTION_XINPUT2) && defined(NATURAL_MOUSE_MOTION_XTEST)
+    interference();
+#else
+    std::printf("Interference not measured, needs libXi and libXtst\n");
+#endif
+}
+
+#else
+
+void X11Benchmark()
+{
+    std::printf("Skipped, X11 only\n");
+}
+
+void InterferenceBenchmark()
+{
+    std::printf("Skipped, X11 only\n");
+}
+
+#endif
+
+} // namespace Benchmark
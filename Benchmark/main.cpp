@@ -0,0 +1,52 @@
+#include <cstring>
+#include <cstdio>
+#include "Benchmark.h"
+
+namespace Benchmark
+{
+volatile double sink = 0;
+bool failed = false;
+}
+
+struct BenchmarkEntry
+{
+    const char *name;
+    void (*run)();
+};
+
+static const BenchmarkEntry benchmarks[] = {
+    {"random", Benchmark::RandomBenchmark},
+    {"plan", Benchmark::PlanBenchmark},
+    {"playback", Benchmark::PlaybackBenchmark},
+    {"simulate", Benchmark::SimulatorBenchmark},
+    {"x11", Benchmark::X11Benchmark},
+    {"interference", Benchmark::InterferenceBenchmark},
+};
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && (std::strcmp(argv[1], "-h") == 0 || std::strcmp(argv[1], "--help") == 0))
+    {
+        std::printf("Usage %s [benchmark...]\nBenchmarks:\n", argv[0]);
+        for (auto &b : benchmarks)
+        {
+            std::printf("\t%s\n", b.name);
+        }
+        return 0;
+    }
+
+    for (auto &b : benchmarks)
+    {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++)
+        {
+            selected = selected || std::strcmp(argv[i], b.name) == 0;
+        }
+        if (selected)
+        {
+            std::printf("== %s ==\n", b.name);
+            b.run();
+        }
+    }
+    return Benchmark::failed ? 1 : 0;
+}
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
@@ -95,6 +96,36 @@ int main(int argc, char **argv){
             {
                 nature.info_printer = NaturalMouseMotion::LoggerPrinterFunc{NaturalMouseMotion::DefaultProvider::DefaultPrinter()};
             }
+            if (input.cmdOptionExists("-hz"))
+            {
+                nature.emissionRateHz = std::abs(atof(input.getCmdOption("-hz").c_str()));
+            }
+            if (input.getCmdOption("-interference") == "abort")
+            {
+                nature.onInterference = NaturalMouseMotion::InterferencePolicy::Abort;
+            }
+            else if (input.getCmdOption("-interference") == "replan")
+            {
+                nature.onInterference = NaturalMouseMotion::InterferencePolicy::Replan;
+            }
+#ifdef NATURAL_MOUSE_MOTION_XTEST
+            if (input.cmdOptionExists("-xtest"))
+            {
+                nature.systemCalls = std::make_shared<NaturalMouseMotion::DefaultProvider::XTestSystemCalls>();
+            }
+#endif
+#ifdef __linux__
+            if (input.cmdOptionExists("-uinput"))
+            {
+                // the size of the screen the absolute device is mapped to, e.g. 1920x1080
+                NaturalMouseMotion::Dimension screenSize{0, 0};
+                if (std::sscanf(input.getCmdOption("-uinput").c_str(), "%dx%d", &screenSize.Width, &screenSize.Height) != 2)
+                {
+                    screenSize = nature.systemCalls->getScreenSize();
+                }
+                nature.systemCalls = std::make_shared<NaturalMouseMotion::DefaultProvider::InputEventSystemCalls>(screenSize);
+            }
+#endif
 
             NaturalMouseMotion::Move(nature, x, y);
         }
@@ -106,6 +137,14 @@ int main(int argc, char **argv){
                   << "Options:\n"
                   << "\t[-i]nfo \t-- Print info messages.\n"
                   << "\t[-d]ebug\t-- Print debug messages.\n"
+                  << "\t-hz rate \t-- One step per tick of rate, e.g. the display refresh rate.\n"
+                  << "\t-interference abort|replan -- Stop or re-plan when the mouse is moved during the move.\n"
+#ifdef NATURAL_MOUSE_MOTION_XTEST
+                  << "\t-xtest  \t-- Move the pointer with XTest motion events.\n"
+#endif
+#ifdef __linux__
+                  << "\t-uinput [WxH]\t-- Move the pointer with a uinput device mapped to a WxH screen.\n"
+#endif
                   << "Nature:\n"
                   << "\t[-g]ranny         -- Low speed, variating flow, lots of noise in movement.\n"
                   << "\t[-a]verage        -- Medium noise, medium speed, medium noise and deviation.\n"
@@ -5,6 +5,13 @@
 
 namespace NaturalMouseMotion
 {
+/**
+ * Nature holding the default providers by their concrete types, so Move and StepKernel can inline them.
+ * The providers can be tweaked but not replaced by other implementations, use MotionNature for that.
+ */
+using InlineMotionNature = BasicMotionNature<DefaultProvider::DefaultNoiseProvider, DefaultProvider::SinusoidalDeviationProvider, DefaultProvider::DefaultSpeedManager,
+                                             std::shared_ptr<DefaultProvider::DefaultOvershootManager>, std::shared_ptr<DefaultProvider::DefaultSystemCalls>, RandomStream>;
+
 struct DefaultNature
 {
     /*
@@ -14,33 +21,26 @@ struct DefaultNature
     {
         MotionNature nature;
 
-        nature.info_printer = nullptr; // LoggerPrinterFunc{DefaultProvider::DefaultPrinter()};
-        nature.debug_printer = nullptr; // LoggerPrinterFunc{DefaultProvider::DefaultPrinter()};
-        nature.observer = nullptr;
-        nature.random = RandomZeroToOneFunc{DefaultProvider::DefaultRandomProvider()};
-        nature.timeToStepsDivider = DefaultProvider::TIME_TO_STEPS_DIVIDER;
-        nature.minSteps = DefaultProvider::MIN_STEPS;
-        nature.effectFadeSteps = DefaultProvider::EFFECT_FADE_STEPS;
-        nature.reactionTimeBaseMs = DefaultProvider::REACTION_TIME_BASE_MS;
-        nature.reactionTimeVariationMs = DefaultProvider::REACTION_TIME_VARIATION_MS;
+        SetDefaults(nature);
         nature.getDeviation = GetDeviationFunc{DefaultProvider::SinusoidalDeviationProvider()};
         nature.getNoise = GetNoiseFunc{DefaultProvider::DefaultNoiseProvider()};
-        nature.overshootManager = std::shared_ptr<OvershootManager>(new DefaultProvider::DefaultOvershootManager(nature.random));
-        nature.systemCalls = std::shared_ptr<SystemCalls>(new DefaultProvider::DefaultSystemCalls());
-        nature.getFlowWithTime =
-            GetFlowWithTimeFunc{DefaultProvider::DefaultSpeedManager(
-                {
-                    FlowTemplates::constantSpeed(),
-                    FlowTemplates::variatingFlow(),
-                    FlowTemplates::interruptedFlow(),
-                    FlowTemplates::interruptedFlow2(),
-                    FlowTemplates::slowStartupFlow(),
-                    FlowTemplates::slowStartup2Flow(),
-                    FlowTemplates::adjustingFlow(),
-                    FlowTemplates::jaggedFlow(),
-                    FlowTemplates::stoppingFlow(),
-                },
-                nature.random)};
+        nature.overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(nature.random);
+        nature.systemCalls = std::make_shared<DefaultProvider::DefaultSystemCalls>();
+        nature.getFlowWithTime = GetFlowWithTimeFunc{DefaultProvider::DefaultSpeedManager(DefaultFlows(), nature.random)};
+        return nature;
+    }
+
+    /*
+    * Returns an InlineMotionNature using all the defaults, moves the same way as NewDefaultNature
+    */
+    static InlineMotionNature NewInlineDefaultNature()
+    {
+        InlineMotionNature nature;
+
+        SetDefaults(nature);
+        nature.overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(nature.random);
+        nature.systemCalls = std::make_shared<DefaultProvider::DefaultSystemCalls>();
+        nature.getFlowWithTime = DefaultProvider::DefaultSpeedManager(DefaultFlows(), nature.random);
         return nature;
     }
 
@@ -57,22 +57,23 @@ struct DefaultNature
         grannyNature.getDeviation = GetDeviationFunc{DefaultProvider::SinusoidalDeviationProvider(9)};
         grannyNature.getNoise = GetNoiseFunc{DefaultProvider::DefaultNoiseProvider(1.6)};
 
-        auto overshootManager = dynamic_cast<DefaultProvider::DefaultOvershootManager*>(grannyNature.overshootManager.get());
+        auto overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(grannyNature.random);
         overshootManager->overshoots = 3;
         overshootManager->minDistanceForOvershoots = 3;
         overshootManager->minOvershootMovementMs = 400;
         overshootManager->overshootRandomModifierDivider = DefaultProvider::DefaultOvershootManager::OVERSHOOT_RANDOM_MODIFIER_DIVIDER / 2;
         overshootManager->overshootSpeedupDivider = DefaultProvider::DefaultOvershootManager::OVERSHOOT_SPEEDUP_DIVIDER * 2;
+        grannyNature.overshootManager = overshootManager;
 
         grannyNature.getFlowWithTime =
             GetFlowWithTimeFunc{DefaultProvider::DefaultSpeedManager(
                 {
-                    FlowTemplates::jaggedFlow(),
+                    Flow(FlowTemplates::jaggedFlow()),
                     FlowTemplates::random(grannyNature.random),
-                    FlowTemplates::interruptedFlow(),
-                    FlowTemplates::interruptedFlow2(),
-                    FlowTemplates::adjustingFlow(),
-                    FlowTemplates::stoppingFlow(),
+                    Flow(FlowTemplates::interruptedFlow()),
+                    Flow(FlowTemplates::interruptedFlow2()),
+                    Flow(FlowTemplates::adjustingFlow()),
+                    Flow(FlowTemplates::stoppingFlow()),
                 },
                 grannyNature.random, 1000)};
         return grannyNature;
@@ -87,10 +88,11 @@ struct DefaultNature
     {
         auto robotNature = NewDefaultNature();
         robotNature.getDeviation = [](double, double) -> Point<double> { return {0.0, 0.0}; };
-        robotNature.getNoise = [](RandomZeroToOneFunc, double, double) -> Point<double> { return {0.0, 0.0}; };
+        robotNature.getNoise = [](const RandomStream &, double, double) -> Point<double> { return {0.0, 0.0}; };
 
-        auto overshootManager = dynamic_cast<DefaultProvider::DefaultOvershootManager*>(robotNature.overshootManager.get());
+        auto overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(robotNature.random);
         overshootManager->overshoots = 0;
+        robotNature.overshootManager = overshootManager;
 
         robotNature.getFlowWithTime = [motionTimeMsPer100Pixels](double distance) -> std::pair<Flow *, time_type>{
             static auto constFlow = Flow(FlowTemplates::constantSpeed());
@@ -111,17 +113,18 @@ struct DefaultNature
 
         gamerNature.reactionTimeVariationMs = 100;
 
-        auto overshootManager = dynamic_cast<DefaultProvider::DefaultOvershootManager*>(gamerNature.overshootManager.get());
+        auto overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(gamerNature.random);
         overshootManager->overshoots = 4;
+        gamerNature.overshootManager = overshootManager;
 
         gamerNature.getFlowWithTime =
             GetFlowWithTimeFunc{DefaultProvider::DefaultSpeedManager(
                 {
-                    FlowTemplates::variatingFlow(),
-                    FlowTemplates::slowStartupFlow(),
-                    FlowTemplates::slowStartup2Flow(),
-                    FlowTemplates::adjustingFlow(),
-                    FlowTemplates::jaggedFlow(),
+                    Flow(FlowTemplates::variatingFlow()),
+                    Flow(FlowTemplates::slowStartupFlow()),
+                    Flow(FlowTemplates::slowStartup2Flow()),
+                    Flow(FlowTemplates::adjustingFlow()),
+                    Flow(FlowTemplates::jaggedFlow()),
                 },
                 gamerNature.random, 250)};
         return gamerNature;
@@ -137,24 +140,58 @@ struct DefaultNature
 
         averageUserNature.reactionTimeVariationMs = 110;
 
-        auto overshootManager = dynamic_cast<DefaultProvider::DefaultOvershootManager*>(averageUserNature.overshootManager.get());
+        auto overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(averageUserNature.random);
         overshootManager->overshoots = 4;
+        averageUserNature.overshootManager = overshootManager;
 
         averageUserNature.getFlowWithTime =
             GetFlowWithTimeFunc{DefaultProvider::DefaultSpeedManager(
                 {
-                    FlowTemplates::variatingFlow(),
-                    FlowTemplates::interruptedFlow(),
-                    FlowTemplates::interruptedFlow2(),
-                    FlowTemplates::slowStartupFlow(),
-                    FlowTemplates::slowStartup2Flow(),
-                    FlowTemplates::adjustingFlow(),
-                    FlowTemplates::jaggedFlow(),
-                    FlowTemplates::stoppingFlow(),
+                    Flow(FlowTemplates::variatingFlow()),
+                    Flow(FlowTemplates::interruptedFlow()),
+                    Flow(FlowTemplates::interruptedFlow2()),
+                    Flow(FlowTemplates::slowStartupFlow()),
+                    Flow(FlowTemplates::slowStartup2Flow()),
+                    Flow(FlowTemplates::adjustingFlow()),
+                    Flow(FlowTemplates::jaggedFlow()),
+                    Flow(FlowTemplates::stoppingFlow()),
                 },
                 averageUserNature.random, 400)};
         return averageUserNature;
     }
+
+private:
+    /**
+     * Sets the loggers, observer, randomness and the numeric settings shared by every nature type
+     */
+    template <typename Nature>
+    static void SetDefaults(Nature &nature)
+    {
+        nature.info_printer = nullptr; // LoggerPrinterFunc{DefaultProvider::DefaultPrinter()};
+        nature.debug_printer = nullptr; // LoggerPrinterFunc{DefaultProvider::DefaultPrinter()};
+        nature.observer = nullptr;
+        nature.random = RandomStream{DefaultProvider::DefaultRandomProvider()};
+        nature.timeToStepsDivider = DefaultProvider::TIME_TO_STEPS_DIVIDER;
+        nature.minSteps = DefaultProvider::MIN_STEPS;
+        nature.effectFadeSteps = DefaultProvider::EFFECT_FADE_STEPS;
+        nature.reactionTimeBaseMs = DefaultProvider::REACTION_TIME_BASE_MS;
+        nature.reactionTimeVariationMs = DefaultProvider::REACTION_TIME_VARIATION_MS;
+    }
+
+    static std::vector<Flow> DefaultFlows()
+    {
+        return {
+            Flow(FlowTemplates::constantSpeed()),
+            Flow(FlowTemplates::variatingFlow()),
+            Flow(FlowTemplates::interruptedFlow()),
+            Flow(FlowTemplates::interruptedFlow2()),
+            Flow(FlowTemplates::slowStartupFlow()),
+            Flow(FlowTemplates::slowStartup2Flow()),
+            Flow(FlowTemplates::adjustingFlow()),
+            Flow(FlowTemplates::jaggedFlow()),
+            Flow(FlowTemplates::stoppingFlow()),
+        };
+    }
 };
 
 } // namespace NaturalMouseMotion
\ No newline at end of file
@@ -1,9 +1,18 @@
 #pragma once
 
 #ifdef __linux__
+#include <time.h>
+#include <cerrno>
 #include "X11/X.h"
 #include "X11/Xlib.h"
 #include "X11/Xutil.h"
+#ifdef NATURAL_MOUSE_MOTION_XRANDR
+#include "X11/extensions/Xrandr.h"
+#endif
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+#include <cstring>
+#include "X11/extensions/XInput2.h"
+#endif
 #elif _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -42,7 +51,8 @@ struct DefaultNoiseProvider
 	{
 	}
 
-	Point<double> operator()(RandomZeroToOneFunc random, double xStepSize, double yStepSize) const
+	template <typename Random>
+	Point<double> operator()(Random &random, double xStepSize, double yStepSize) const
 	{
 		if (std::abs(xStepSize - 0.0) < SMALL_DELTA && std::abs(yStepSize - 0.0) < SMALL_DELTA)
 		{
@@ -52,10 +62,13 @@ struct DefaultNoiseProvider
 		double noiseY = 0.0;
 		auto stepSize = std::hypot(xStepSize, yStepSize);
 		auto noisiness = std::max(0.0, (8 - stepSize)) / 50;
+		// Most steps get no noise, so only the gate is drawn for them
 		if (random() < noisiness)
 		{
-			noiseX = (random() - 0.5) * std::max(0.0, (8 - stepSize)) / noisinessDivider;
-			noiseY = (random() - 0.5) * std::max(0.0, (8 - stepSize)) / noisinessDivider;
+			double rands[2];
+			RandomFill::Fill(random, rands, 2);
+			noiseX = (rands[0] - 0.5) * std::max(0.0, (8 - stepSize)) / noisinessDivider;
+			noiseY = (rands[1] - 0.5) * std::max(0.0, (8 - stepSize)) / noisinessDivider;
 		}
 		return {noiseX, noiseY};
 	}
@@ -68,9 +81,9 @@ private:
 /**
  * Overshoots provide a realistic way to simulate user trying to reach the destination with mouse, but miss.
  */
-struct DefaultOvershootManager : public OvershootManager
+struct DefaultOvershootManager final : public OvershootManager
 {
-	DefaultOvershootManager(RandomZeroToOneFunc random) : random(random)
+	DefaultOvershootManager(RandomStream random) : random(random)
 	{
 	}
 
@@ -87,8 +100,10 @@ struct DefaultOvershootManager : public OvershootManager
 	{
 		auto distanceToRealTarget = std::hypot(distanceToRealTargetX, distanceToRealTargetY);
 		auto randomModifier = distanceToRealTarget / overshootRandomModifierDivider;
-		int x = (int)(random() * randomModifier - randomModifier / 2.0) * overshootsRemaining;
-		int y = (int)(random() * randomModifier - randomModifier / 2.0) * overshootsRemaining;
+		double rands[2];
+		random.fill(rands, 2);
+		int x = (int)(rands[0] * randomModifier - randomModifier / 2.0) * overshootsRemaining;
+		int y = (int)(rands[1] * randomModifier - randomModifier / 2.0) * overshootsRemaining;
 		return {x, y};
 	}
 
@@ -108,7 +123,7 @@ struct DefaultOvershootManager : public OvershootManager
 	double overshootRandomModifierDivider{OVERSHOOT_RANDOM_MODIFIER_DIVIDER};
 	double overshootSpeedupDivider{OVERSHOOT_SPEEDUP_DIVIDER};
 	int overshoots{DEFAULT_OVERSHOOT_AMOUNT};
-	RandomZeroToOneFunc random;
+	RandomStream random;
 };
 
 /**
@@ -138,7 +153,14 @@ private:
  */
 struct DefaultSpeedManager
 {
-	DefaultSpeedManager(std::vector<Flow> flows, RandomZeroToOneFunc random, time_type mouseMovementSpeedMs = 500) : flows(flows), random(random), mouseMovementTimeMs(mouseMovementSpeedMs)
+	/**
+	 * Speed manager without flows, returns no flow until replaced by one with flows
+	 */
+	DefaultSpeedManager() : DefaultSpeedManager({}, RandomStream())
+	{
+	}
+
+	DefaultSpeedManager(std::vector<Flow> flows, RandomStream random, time_type mouseMovementSpeedMs = 500) : flows(flows), random(random), mouseMovementTimeMs(mouseMovementSpeedMs)
 	{
 	}
 
@@ -154,28 +176,313 @@ struct DefaultSpeedManager
 
 		// pick a random flow
 		auto &flow = flows[static_cast<size_t>(random() * flows.size()) % flows.size()];
-		auto timePerBucket = time / static_cast<double>(flow.getFlowCharacteristics().size());
-		for (auto bucket : flow.getFlowCharacteristics())
+		auto timePerBucket = time / static_cast<double>(flow.getBucketCount());
+		// the cursor is stopped during zero buckets, add time so it still moves for the planned time
+		time += static_cast<time_type>(flow.getZeroBucketCount()) * (time_type)timePerBucket;
+		return {&flow, time};
+	}
+
+private:
+	std::vector<Flow> flows;
+	RandomStream random;
+	time_type mouseMovementTimeMs;
+};
+
+/**
+ * Monotonic clock and precise waiting
+ */
+struct SteadyClock
+{
+	/**
+	 * Sleeping is only accurate to the scheduler's granularity, this much of every wait is spun instead.
+	 */
+#ifdef _WIN32
+	static constexpr time_type DEFAULT_SPIN_NANOS{2 * NANOS_IN_MILLI};
+#else
+	static constexpr time_type DEFAULT_SPIN_NANOS{200000};
+#endif
+
+	/**
+	 * @return CLOCK_MONOTONIC on Linux, std::chrono::steady_clock elsewhere
+	 */
+	static time_type Nanos()
+	{
+#ifdef __linux__
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<time_type>(now.tv_sec) * NANOS_IN_SECOND + now.tv_nsec;
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	/**
+	 * Sleeps coarsely until spinNanos remain, then spins for the rest, so the wait neither over nor undersleeps.
+	 */
+	static void SleepNanos(time_type nanos, time_type spinNanos = DEFAULT_SPIN_NANOS)
+	{
+		SleepUntilNanos(Nanos() + nanos, spinNanos);
+	}
+
+	/**
+	 * Waits until Nanos() reaches deadline. On Linux the sleep targets the absolute deadline with
+	 * clock_nanosleep, so being preempted before going to sleep doesn't make the wait any longer.
+	 */
+	static void SleepUntilNanos(time_type deadline, time_type spinNanos = DEFAULT_SPIN_NANOS)
+	{
+		auto wake = deadline - spinNanos;
+#ifdef __linux__
+		timespec wakeTime;
+		wakeTime.tv_sec = static_cast<time_t>(wake / NANOS_IN_SECOND);
+		wakeTime.tv_nsec = static_cast<long>(wake % NANOS_IN_SECOND);
+		while (wake > 0 && clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, nullptr) == EINTR)
+		{
+		}
+#else
+		auto left = wake - Nanos();
+		if (left > 0)
 		{
-			if (std::abs(bucket - 0) < SMALL_DELTA)
+			std::this_thread::sleep_for(std::chrono::nanoseconds(left));
+		}
+#endif
+		while (Nanos() < deadline)
+		{
+		}
+	}
+
+private:
+	static constexpr time_type NANOS_IN_SECOND{1000 * NANOS_IN_MILLI};
+};
+
+#ifdef __linux__
+/**
+ * Size and monitors of an X screen without a round-trip per read. Listens for the ConfigureNotify events the root
+ * window gets when RandR resizes the screen, and takes the new size from them when it is asked for.
+ * With libXrandr (NATURAL_MOUSE_MOTION_XRANDR) the monitors are RandR's, asked for again only after a resize or a
+ * RandR screen change event, which also comes when monitors are moved without resizing the screen.
+ * Without it the screen is a single monitor.
+ */
+struct X11ScreenGeometry
+{
+	X11ScreenGeometry(Display *display, Window root, int screen) : display(display), root(root)
+	{
+		Screen *scr = ScreenOfDisplay(display, screen);
+		size = {scr->width, scr->height};
+#ifdef NATURAL_MOUSE_MOTION_XRANDR
+		int errorBase, major, minor;
+		// Monitors came with RandR 1.5
+		randr = XRRQueryExtension(display, &randrEventBase, &errorBase) && XRRQueryVersion(display, &major, &minor) && (major > 1 || minor >= 5);
+		if (randr)
+		{
+			XRRSelectInput(display, root, RRScreenChangeNotifyMask);
+		}
+#endif
+		layout = std::make_shared<const ScreenLayout>(queryLayout());
+	}
+
+	/**
+	 * @return the event mask to select on the root window, which has to include StructureNotifyMask
+	 */
+	static long EventMask()
+	{
+		return StructureNotifyMask;
+	}
+
+	Dimension get()
+	{
+		update();
+		return size;
+	}
+
+	/**
+	 * @return the monitors, a new layout is made only when they changed and the old one lives on with its holders
+	 */
+	std::shared_ptr<const ScreenLayout> getLayout()
+	{
+		update();
+		return layout;
+	}
+
+private:
+	Display *display;
+	Window root;
+	Dimension size;
+	std::shared_ptr<const ScreenLayout> layout{};
+#ifdef NATURAL_MOUSE_MOTION_XRANDR
+	bool randr{false};
+	int randrEventBase{0};
+#endif
+
+	void update()
+	{
+		// Only looks at what has already arrived, doesn't wait for the server
+		bool changed = false;
+		XEvent event;
+		while (XCheckTypedWindowEvent(display, root, ConfigureNotify, &event))
+		{
+			size = {event.xconfigure.width, event.xconfigure.height};
+			changed = true;
+		}
+#ifdef NATURAL_MOUSE_MOTION_XRANDR
+		while (randr && XCheckTypedWindowEvent(display, root, randrEventBase + RRScreenChangeNotify, &event))
+		{
+			XRRUpdateConfiguration(&event);
+			changed = true;
+		}
+#endif
+		if (changed)
+		{
+			layout = std::make_shared<const ScreenLayout>(queryLayout());
+		}
+	}
+
+	ScreenLayout queryLayout()
+	{
+#ifdef NATURAL_MOUSE_MOTION_XRANDR
+		if (randr)
+		{
+			int count = 0;
+			XRRMonitorInfo *monitors = XRRGetMonitors(display, root, True, &count);
+			std::vector<Rect> rects;
+			for (int i = 0; i < count; i++)
+			{
+				rects.push_back({monitors[i].x, monitors[i].y, monitors[i].width, monitors[i].height});
+			}
+			if (monitors)
 			{
-				time += (time_type)timePerBucket;
+				XRRFreeMonitors(monitors);
+			}
+			if (!rects.empty())
+			{
+				return ScreenLayout(std::move(rects));
 			}
 		}
-		return {&flow, time};
+#endif
+		return ScreenLayout(size);
+	}
+};
+
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+/**
+ * Notices pointer motion this client didn't make, from XInput2 raw motion events. Raw events come from the
+ * input devices as they are handled, even while another client grabs the pointer, and warping the pointer
+ * doesn't cause any. Reading them doesn't wait for the server.
+ * Needs libXi (NATURAL_MOUSE_MOTION_XINPUT2), without XInput 2 on the server nothing is noticed.
+ */
+struct X11RawMotionListener
+{
+	/**
+	 * @param ignoredDevice name of the device whose motion is this client's own, e.g. the XTest pointer, may be nullptr
+	 */
+	X11RawMotionListener(Display *display, Window root, const char *ignoredDevice) : display(display), root(root)
+	{
+		int eventBase, errorBase;
+		int major = 2, minor = 0;
+		if (!XQueryExtension(display, "XInputExtension", &opcode, &eventBase, &errorBase) || XIQueryVersion(display, &major, &minor) != Success)
+		{
+			opcode = -1;
+			return;
+		}
+		if (ignoredDevice)
+		{
+			int count = 0;
+			XIDeviceInfo *devices = XIQueryDevice(display, XIAllDevices, &count);
+			for (int i = 0; i < count; i++)
+			{
+				if (std::strcmp(devices[i].name, ignoredDevice) == 0)
+				{
+					ignoredDeviceId = devices[i].deviceid;
+				}
+			}
+			XIFreeDeviceInfo(devices);
+		}
+	}
+
+	/**
+	 * Raw motion is only selected while watched, so it doesn't pile up in the event queue between moves.
+	 * Whatever arrived before watching starts is discarded, and so is what arrives after it ends. Watches nest.
+	 */
+	void watch(bool watching)
+	{
+		if (opcode < 0)
+		{
+			return;
+		}
+		if (watching)
+		{
+			if (watchers++ == 0)
+			{
+				// Left over from the last watch, sent before the server saw it end
+				take();
+				select(true);
+			}
+		}
+		else if (watchers > 0 && --watchers == 0)
+		{
+			select(false);
+			take();
+		}
+	}
+
+	/**
+	 * @return true when the pointer was moved by a device since the last call
+	 */
+	bool take()
+	{
+		bool moved = false;
+		XEvent event;
+		while (opcode >= 0 && XCheckTypedEvent(display, GenericEvent, &event))
+		{
+			XGenericEventCookie *cookie = &event.xcookie;
+			if (cookie->extension == opcode && XGetEventData(display, cookie))
+			{
+				if (cookie->evtype == XI_RawMotion && static_cast<XIRawEvent *>(cookie->data)->sourceid != ignoredDeviceId)
+				{
+					moved = true;
+				}
+				XFreeEventData(display, cookie);
+			}
+		}
+		return moved;
+	}
+
+	/**
+	 * @return true while raw motion is selected, so take reports every device motion
+	 */
+	bool watching() const
+	{
+		return opcode >= 0 && watchers > 0;
 	}
 
 private:
-	static constexpr double SMALL_DELTA{1.0E-5};
-	std::vector<Flow> flows;
-	RandomZeroToOneFunc random;
-	time_type mouseMovementTimeMs;
+	Display *display;
+	Window root;
+	int opcode{-1};
+	int ignoredDeviceId{-1};
+	int watchers{0};
+
+	void select(bool rawMotion)
+	{
+		unsigned char mask[XIMaskLen(XI_LASTEVENT)] = {};
+		if (rawMotion)
+		{
+			XISetMask(mask, XI_RawMotion);
+		}
+		XIEventMask eventMask;
+		eventMask.deviceid = XIAllMasterDevices;
+		eventMask.mask_len = sizeof(mask);
+		eventMask.mask = mask;
+		XISelectEvents(display, root, &eventMask, 1);
+		XFlush(display);
+	}
 };
+#endif
+#endif
 
 /*
  * Basic system calls
  */
-struct DefaultSystemCalls : public SystemCalls
+struct DefaultSystemCalls final : public SystemCalls
 {
 #ifdef __linux__
 	Display *display;
@@ -191,6 +498,13 @@ struct DefaultSystemCalls : public SystemCalls
 	    for (int i = 0; i < number_of_screens; i++) {
 	    	root_windows.push_back(XRootWindow(display, i));
 	    }
+	    // Selected once here rather than with every warp
+	    XSelectInput(display, root_windows[screen], KeyReleaseMask | X11ScreenGeometry::EventMask());
+	    geometry.reset(new X11ScreenGeometry(display, root_windows[screen], screen));
+	    pointerRoot = screen;
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+	    rawMotion.reset(new X11RawMotionListener(display, root_windows[screen], nullptr));
+#endif
 	}
 
 	~DefaultSystemCalls()
@@ -198,38 +512,110 @@ struct DefaultSystemCalls : public SystemCalls
 		XCloseDisplay(display);
 	}
 
+	DefaultSystemCalls(const DefaultSystemCalls &) = delete;
+	DefaultSystemCalls &operator=(const DefaultSystemCalls &) = delete;
+
 	Dimension getScreenSize() override
 	{
-		Screen *scr = ScreenOfDisplay(display, screen);
-		return {scr->width, scr->height};
+		return geometry->get();
 	}
 
+	std::shared_ptr<const ScreenLayout> getScreenLayout() override
+	{
+		return geometry->getLayout();
+	}
+
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+	/**
+	 * Any raw motion is foreign, warps don't cause raw events
+	 */
+	bool takeForeignMotion() override
+	{
+		bool moved = foreignMotion || rawMotion->take();
+		foreignMotion = false;
+		if (moved)
+		{
+			warped = false;
+		}
+		return moved;
+	}
+
+	void watchForeignMotion(bool watching) override
+	{
+		bool wasWatching = rawMotion->watching();
+		rawMotion->watch(watching);
+		if (wasWatching != rawMotion->watching())
+		{
+			// The cursor may have been moved while nobody watched
+			foreignMotion = false;
+			warped = false;
+		}
+	}
+#endif
+
 	void setMousePosition(int x, int y) override
 	{
-		XSelectInput(display, root_windows[screen], KeyReleaseMask);
 		XWarpPointer(display, None, root_windows[screen], 0, 0, 0, 0, x, y);
 		XFlush(display);
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+		lastWarped = {x, y};
+		warped = true;
+#endif
 	}
 
+	/**
+	 * Asks the server, the cursor is wherever the user or the server put it, not necessarily where it was warped to.
+	 * While foreign motion is watched and there was none since the last warp, the cursor is still where it was
+	 * warped to and the server isn't asked.
+	 * The root window the pointer was found on last time is asked first.
+	 */
 	Point<int> getMousePosition() override
 	{
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+		if (warped && rawMotion->watching())
+		{
+			// Kept for takeForeignMotion, which the move asks next
+			foreignMotion = foreignMotion || rawMotion->take();
+			if (!foreignMotion)
+			{
+				return lastWarped;
+			}
+			warped = false;
+		}
+#endif
 	    Window window_returned;
 	    int root_x, root_y;
 	    int win_x, win_y;
 	    unsigned int mask_return;
 
-	    for (auto& r: root_windows)
+	    for (size_t i = 0; i < root_windows.size(); i++)
 	    {
-	        if (XQueryPointer(display, r, &window_returned,
+	        auto root = (pointerRoot + i) % root_windows.size();
+	        if (XQueryPointer(display, root_windows[root], &window_returned,
 	                &window_returned, &root_x, &root_y, &win_x, &win_y,
 	                &mask_return))
 	        {
+	            pointerRoot = root;
 	            return {root_x, root_y};
 	        }
 	    }
         // No mouse found
         return {0, 0};
 	}
+
+private:
+	std::unique_ptr<X11ScreenGeometry> geometry;
+	// Index of the root window the pointer was last found on
+	size_t pointerRoot{0};
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+	std::unique_ptr<X11RawMotionListener> rawMotion;
+	Point<int> lastWarped{0, 0};
+	// Whether the cursor was warped during the current watch and not moved by anything else since
+	bool warped{false};
+	// Raw motion getMousePosition took before takeForeignMotion did
+	bool foreignMotion{false};
+#endif
+public:
 #elif _WIN32
 	Dimension getScreenSize() override
 	{
@@ -247,22 +633,65 @@ struct DefaultSystemCalls : public SystemCalls
 		GetCursorPos(&pt);
 		return {pt.x, pt.y};
 	}
+
+	/**
+	 * Monitors are enumerated again only when their count or the virtual screen they span changes
+	 */
+	std::shared_ptr<const ScreenLayout> getScreenLayout() override
+	{
+		Rect virtualScreen{GetSystemMetrics(SM_XVIRTUALSCREEN), GetSystemMetrics(SM_YVIRTUALSCREEN),
+			GetSystemMetrics(SM_CXVIRTUALSCREEN), GetSystemMetrics(SM_CYVIRTUALSCREEN)};
+		int monitorCount = GetSystemMetrics(SM_CMONITORS);
+		auto &bounds = layout->getBounds();
+		if (monitorCount != (int)layout->getMonitors().size() || virtualScreen.x != bounds.x || virtualScreen.y != bounds.y
+			|| virtualScreen.width != bounds.width || virtualScreen.height != bounds.height)
+		{
+			std::vector<Rect> monitors;
+			EnumDisplayMonitors(nullptr, nullptr, [](HMONITOR, HDC, LPRECT rect, LPARAM data) -> BOOL {
+				reinterpret_cast<std::vector<Rect> *>(data)->push_back({rect->left, rect->top, rect->right - rect->left, rect->bottom - rect->top});
+				return TRUE;
+			}, reinterpret_cast<LPARAM>(&monitors));
+			layout = std::make_shared<const ScreenLayout>(std::move(monitors));
+		}
+		return layout;
+	}
+
+private:
+	std::shared_ptr<const ScreenLayout> layout{std::make_shared<const ScreenLayout>()};
+public:
 #else
 	#error unsupported OS
 #endif
 
 	time_type currentTimeMillis() override
 	{
-		std::chrono::time_point<std::chrono::system_clock> now = std::chrono::system_clock::now();
-		auto duration = now.time_since_epoch();
-		auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
-		return millis;
+		return SteadyClock::Nanos() / NANOS_IN_MILLI;
 	}
 
 	void sleep(time_type time) override
 	{
 		std::this_thread::sleep_for(std::chrono::milliseconds(time));
 	}
+
+	time_type currentTimeNanos() override
+	{
+		return SteadyClock::Nanos();
+	}
+
+	void sleepNanos(time_type nanos) override
+	{
+		SteadyClock::SleepNanos(nanos, spinNanos);
+	}
+
+	void sleepUntilNanos(time_type deadline) override
+	{
+		SteadyClock::SleepUntilNanos(deadline, spinNanos);
+	}
+
+	/**
+	 * Part of every step wait that is spun, trading CPU time for accurate step timing
+	 */
+	time_type spinNanos{SteadyClock::DEFAULT_SPIN_NANOS};
 };
 
 /**
@@ -286,6 +715,169 @@ private:
 	std::uniform_real_distribution<double> dist{0.0f, 1.0f};
 };
 
+/**
+ * Fast source of randomness, xoshiro256++ with 53 bit doubles.
+ * Has a fill method so a RandomStream can hand out many values with one indirect call.
+ */
+struct FastRandomProvider
+{
+	FastRandomProvider()
+	{
+		std::random_device rnd_device;
+		seed((static_cast<uint64_t>(rnd_device()) << 32) | rnd_device());
+	}
+
+	FastRandomProvider(uint64_t seedValue)
+	{
+		seed(seedValue);
+	}
+
+	double operator()()
+	{
+		return (next() >> 11) * DOUBLE_UNIT;
+	}
+
+	void fill(double *out, size_t n)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			out[i] = (next() >> 11) * DOUBLE_UNIT;
+		}
+	}
+
+private:
+	static constexpr double DOUBLE_UNIT{1.0 / 9007199254740992.0}; // 2^-53
+	uint64_t state[4];
+
+	void seed(uint64_t seedValue)
+	{
+		// splitmix64, so that similar seeds still give unrelated states
+		for (auto &s : state)
+		{
+			uint64_t z = (seedValue += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			s = z ^ (z >> 31);
+		}
+	}
+
+	static uint64_t rotl(uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	uint64_t next()
+	{
+		uint64_t result = rotl(state[0] + state[3], 23) + state[0];
+		uint64_t t = state[1] << 17;
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = rotl(state[3], 45);
+		return result;
+	}
+};
+
+/**
+ * Counter based random provider, Philox4x32-10.
+ * Every value is a pure function of (seed, stream, draw index) rather than of the values drawn before it,
+ * so using the move index as the stream any trajectory can be reproduced on any thread, in any order,
+ * without sharing generator state: generating move 1000000 gives the same output whether it runs first or last.
+ * Give every thread its own nature with its own provider and call seek before each move,
+ * e.g. nature.random.target<CounterRandomProvider>()->seek(moveIndex).
+ */
+struct CounterRandomProvider
+{
+	CounterRandomProvider(uint64_t seed, uint64_t stream = 0) : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}
+	{
+		seek(stream);
+	}
+
+	/**
+	 * Restarts the sequence of stream at draw index draw
+	 */
+	void seek(uint64_t stream, uint64_t draw = 0)
+	{
+		currentStream = stream;
+		nextDraw = draw;
+		cachedBlock = NO_BLOCK;
+	}
+
+	uint64_t getStream() const
+	{
+		return currentStream;
+	}
+
+	/**
+	 * @return index of the value the next call returns
+	 */
+	uint64_t getDraw() const
+	{
+		return nextDraw;
+	}
+
+	double operator()()
+	{
+		auto block = nextDraw / DRAWS_PER_BLOCK;
+		if (block != cachedBlock)
+		{
+			generate(block, values);
+			cachedBlock = block;
+		}
+		return values[nextDraw++ % DRAWS_PER_BLOCK];
+	}
+
+	void fill(double *out, size_t n)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			out[i] = (*this)();
+		}
+	}
+
+private:
+	static constexpr uint64_t DRAWS_PER_BLOCK{2};
+	static constexpr uint64_t NO_BLOCK{~0ULL};
+	static constexpr double DOUBLE_UNIT{1.0 / 9007199254740992.0}; // 2^-53
+
+	uint32_t key[2];
+	uint64_t currentStream{0};
+	uint64_t nextDraw{0};
+	uint64_t cachedBlock{NO_BLOCK};
+	double values[DRAWS_PER_BLOCK];
+
+	static void round(uint32_t (&ctr)[4], const uint32_t (&k)[2])
+	{
+		uint64_t p0 = static_cast<uint64_t>(0xD2511F53U) * ctr[0];
+		uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57U) * ctr[2];
+		uint32_t c1 = ctr[1];
+		uint32_t c3 = ctr[3];
+		ctr[0] = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k[0];
+		ctr[1] = static_cast<uint32_t>(p1);
+		ctr[2] = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k[1];
+		ctr[3] = static_cast<uint32_t>(p0);
+	}
+
+	/**
+	 * Encrypts the counter (block, stream) with the seed as the key, 128 bits give two doubles
+	 */
+	void generate(uint64_t block, double (&out)[DRAWS_PER_BLOCK]) const
+	{
+		uint32_t ctr[4] = {static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32), static_cast<uint32_t>(currentStream), static_cast<uint32_t>(currentStream >> 32)};
+		uint32_t k[2] = {key[0], key[1]};
+		for (int i = 0; i < 10; i++)
+		{
+			round(ctr, k);
+			k[0] += 0x9E3779B9U;
+			k[1] += 0xBB67AE85U;
+		}
+		out[0] = (((static_cast<uint64_t>(ctr[0]) << 32) | ctr[1]) >> 11) * DOUBLE_UNIT;
+		out[1] = (((static_cast<uint64_t>(ctr[2]) << 32) | ctr[3]) >> 11) * DOUBLE_UNIT;
+	}
+};
+
 /*
  * Simple console printer
  */
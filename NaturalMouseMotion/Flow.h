@@ -1,7 +1,10 @@
 #pragma once
 
 #include <vector>
+#include <array>
+#include <memory>
 #include <cstdint>
+#include <cstddef>
 #include <stdexcept>
 
 namespace NaturalMouseMotion
@@ -9,6 +12,55 @@ namespace NaturalMouseMotion
 
 using FlowCharacteristicsContainer = std::vector<double>;
 
+template <size_t N>
+struct FlowTemplate;
+
+/**
+ * Non-owning, read only view of the normalized buckets of a Flow.
+ * Valid as long as the Flow, or any copy of it, is alive.
+ */
+class FlowBuckets
+{
+public:
+	FlowBuckets(const double *data, size_t size) : first(data), count(size)
+	{
+	}
+
+	const double *begin() const
+	{
+		return first;
+	}
+
+	const double *end() const
+	{
+		return first + count;
+	}
+
+	const double *data() const
+	{
+		return first;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	double operator[](size_t i) const
+	{
+		return first[i];
+	}
+
+private:
+	const double *first;
+	size_t count;
+};
+
 /**
  * Flow for the mouse movement
  * Flow defines how slow or fast the cursor is moving at a particular moment, defining the characteristics
@@ -17,6 +69,13 @@ using FlowCharacteristicsContainer = std::vector<double>;
 class Flow
 {
 public:
+	static constexpr int AVERAGE_BUCKET_VALUE{100};
+
+	/**
+	 * Normalized buckets below this value are considered zero, the cursor is stopped during them.
+	 */
+	static constexpr double ZERO_BUCKET_DELTA{1.0E-5};
+
 	/**
 	 * @param characteristics the characteristics array, which can be any size, contain non-negative numbers.
 	 * The values in the array are translated to flow and all values are relative. For example an
@@ -26,13 +85,60 @@ public:
 	 * 25% of time and the movement is accelerating - in the last 25% of time the mouse cursor is 4 times faster
 	 * than it was in the first 25% of the time.
 	 */
-	Flow(FlowCharacteristicsContainer characteristics) : buckets(normalizeBuckets(characteristics))
+	Flow(const FlowCharacteristicsContainer &characteristics) : storage(buildStorage(characteristics)), bucketCount(characteristics.size()),
+		buckets(storage->data()), cumulativeBuckets(storage->data() + bucketCount), zeroBucketCount(countZeroBuckets(buckets, bucketCount))
+	{
+	}
+
+	/**
+	 * Refers to the already normalized template without copying or allocating.
+	 * Explicit, and not from temporaries, as the flow keeps pointers into the template.
+	 * @param flowTemplate the template, must outlive the flow
+	 */
+	template <size_t N>
+	explicit Flow(const FlowTemplate<N> &flowTemplate) : bucketCount(N), buckets(flowTemplate.buckets.data()), cumulativeBuckets(flowTemplate.cumulative.data()),
+		zeroBucketCount(flowTemplate.zeroBucketCount)
 	{
 	}
 
+	template <size_t N>
+	Flow(const FlowTemplate<N> &&) = delete;
+
+	/**
+	 * @return a copy of the normalized buckets, prefer getBuckets when a view is enough
+	 */
 	FlowCharacteristicsContainer getFlowCharacteristics() const
 	{
-		return buckets;
+		return FlowCharacteristicsContainer(buckets, buckets + bucketCount);
+	}
+
+	/**
+	 * @return view of the normalized buckets, without copying
+	 */
+	FlowBuckets getBuckets() const
+	{
+		return FlowBuckets(buckets, bucketCount);
+	}
+
+	size_t getBucketCount() const
+	{
+		return bucketCount;
+	}
+
+	/**
+	 * @return number of buckets during which the cursor is stopped, see ZERO_BUCKET_DELTA
+	 */
+	size_t getZeroBucketCount() const
+	{
+		return zeroBucketCount;
+	}
+
+	/**
+	 * @return fraction of the movement time the cursor is stopped, from 0 to 1
+	 */
+	double getStoppedTimeFraction() const
+	{
+		return zeroBucketCount / static_cast<double>(bucketCount);
 	}
 
 	/**
@@ -45,25 +151,61 @@ public:
 	double getStepSize(double distance, int steps, double completion) const
 	{
 		auto completionStep = 1.0 / steps;
-		auto bucketFrom = (completion * buckets.size());
-		auto bucketUntil = ((completion + completionStep) * buckets.size());
+		auto bucketFrom = (completion * bucketCount);
+		auto bucketUntil = ((completion + completionStep) * bucketCount);
 		auto bucketContents = getBucketsContents(bucketFrom, bucketUntil);
-		auto distancePerBucketContent = distance / (buckets.size() * AVERAGE_BUCKET_VALUE);
+		auto distancePerBucketContent = distance / (bucketCount * AVERAGE_BUCKET_VALUE);
 		return bucketContents * distancePerBucketContent;
 	}
 
+	/**
+	 * This returns the distance covered on a single axis from the beginning of the movement until completion.
+	 * A step is the difference of two covered distances, so a whole movement can be planned with one call per step.
+	 * @param distance the total distance current movement has on current axis from beginning to target in pixels
+	 * @param completion value between 0 and 1, the value describes movement completion in time
+	 * @return the distance covered when completion of the movement time has passed
+	 */
+	double getDistanceCovered(double distance, double completion) const
+	{
+		auto distancePerBucketContent = distance / (bucketCount * AVERAGE_BUCKET_VALUE);
+		return getCumulativeContents(completion * bucketCount) * distancePerBucketContent;
+	}
+
 private:
-	static constexpr int AVERAGE_BUCKET_VALUE{100};
-	FlowCharacteristicsContainer buckets{};
+	/**
+	 * Normalized buckets followed by their running sums, empty for flows referring to a FlowTemplate
+	 */
+	std::shared_ptr<const FlowCharacteristicsContainer> storage{};
+	size_t bucketCount{0};
+	const double *buckets{nullptr};
+	/**
+	 * cumulativeBuckets[i] is the sum of buckets[0] .. buckets[i - 1], so it has one element more than buckets
+	 */
+	const double *cumulativeBuckets{nullptr};
+	size_t zeroBucketCount{0};
+
+	static size_t countZeroBuckets(const double *normalizedBuckets, size_t size)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < size; i++)
+		{
+			if (normalizedBuckets[i] < ZERO_BUCKET_DELTA)
+			{
+				count++;
+			}
+		}
+		return count;
+	}
 
 	/**
-	 * Normalizes the characteristics to have an average of AVERAGE_BUCKET_VALUE
+	 * Normalizes the characteristics to have an average of AVERAGE_BUCKET_VALUE and appends their running sums
 	 * @param flowCharacteristics an array of values which describe how the mouse should move at each moment
-	 * @return the normalized bucket array
+	 * @return the normalized bucket array followed by the running sums, 2 * size + 1 elements
 	 */
-	static FlowCharacteristicsContainer normalizeBuckets(FlowCharacteristicsContainer flowCharacteristics)
+	static std::shared_ptr<const FlowCharacteristicsContainer> buildStorage(const FlowCharacteristicsContainer &flowCharacteristics)
 	{
-		auto buk = FlowCharacteristicsContainer(flowCharacteristics.size());
+		auto size = flowCharacteristics.size();
+		auto buk = std::make_shared<FlowCharacteristicsContainer>(2 * size + 1);
 		double sum = 0;
 		for (auto &v : flowCharacteristics)
 		{
@@ -77,14 +219,38 @@ private:
 		{
 			throw std::runtime_error("Invalid FlowCharacteristics. All array elements can't be 0.");
 		}
-		auto multiplier = static_cast<double>(AVERAGE_BUCKET_VALUE) * buk.size() / sum;
-		for (size_t i = 0; i < flowCharacteristics.size(); i++)
+		auto multiplier = static_cast<double>(AVERAGE_BUCKET_VALUE) * size / sum;
+		double cumulative = 0;
+		for (size_t i = 0; i < size; i++)
 		{
-			buk[i] = flowCharacteristics[i] * multiplier;
+			(*buk)[i] = flowCharacteristics[i] * multiplier;
+			(*buk)[size + i] = cumulative;
+			cumulative += (*buk)[i];
 		}
+		(*buk)[2 * size] = cumulative;
 		return buk;
 	}
 
+	/**
+	 * Summarizes the bucket contents from the start of the flow up to bucket, where bucket may have
+	 * decimal places. In that case the last bucket is only counted by the fraction the decimal place contains.
+	 * @param bucket bucket where to read, values outside [0, bucketCount] are clamped
+	 * @return the sum of the contents in the buckets
+	 */
+	double getCumulativeContents(double bucket) const
+	{
+		if (bucket <= 0)
+		{
+			return 0;
+		}
+		if (bucket >= bucketCount)
+		{
+			return cumulativeBuckets[bucketCount];
+		}
+		auto index = static_cast<size_t>(bucket);
+		return cumulativeBuckets[index] + buckets[index] * (bucket - index);
+	}
+
 	/**
 	 * Summarizes the bucket contents from bucketFrom to bucketUntil, where
 	 * provided parameters may have decimal places. In that case the value
@@ -97,25 +263,77 @@ private:
 	 */
 	double getBucketsContents(double bucketFrom, double bucketUntil) const
 	{
-		double sum = 0;
-		for (auto i = static_cast<int>(bucketFrom); i < bucketUntil; i++)
-		{
-			auto value = buckets[i];
-			double endMultiplier = 1;
-			double startMultiplier = 0;
-			if (bucketUntil < i + 1)
-			{
-				endMultiplier = bucketUntil - static_cast<int>(bucketUntil);
-			}
-			if (static_cast<int>(bucketFrom) == i)
-			{
-				startMultiplier = bucketFrom - static_cast<int>(bucketFrom);
-			}
-			value *= endMultiplier - startMultiplier;
-			sum += value;
-		}
-		return sum;
+		return getCumulativeContents(bucketUntil) - getCumulativeContents(bucketFrom);
+	}
+};
+
+/**
+ * Flow characteristics which are normalized, and have their running sums calculated, at compile time.
+ * A Flow constructed from a FlowTemplate refers to its arrays instead of copying them,
+ * so templates must have static storage duration. Use FlowTemplate::Normalize to create one.
+ */
+template <size_t N>
+struct FlowTemplate
+{
+	std::array<double, N> buckets;
+	std::array<double, N + 1> cumulative;
+	size_t zeroBucketCount;
+
+	/**
+	 * @return the normalized characteristics
+	 */
+	operator FlowCharacteristicsContainer() const
+	{
+		return FlowCharacteristicsContainer(buckets.begin(), buckets.end());
+	}
+
+	/**
+	 * Normalizes the characteristics to have an average of Flow::AVERAGE_BUCKET_VALUE.
+	 * Gives the same values as normalizing in the Flow constructor. Invalid characteristics fail to compile.
+	 */
+	static constexpr FlowTemplate Normalize(const double (&characteristics)[N])
+	{
+		return build(characteristics, static_cast<double>(Flow::AVERAGE_BUCKET_VALUE) * N / validatedSum(characteristics, 0, 0), typename MakeIndexSequence<N>::type{}, typename MakeIndexSequence<N + 1>::type{});
+	}
+
+private:
+	template <size_t... I>
+	struct IndexSequence
+	{
+	};
+
+	template <size_t M, size_t... I>
+	struct MakeIndexSequence : MakeIndexSequence<M - 1, M - 1, I...>
+	{
+	};
+
+	template <size_t... I>
+	struct MakeIndexSequence<0, I...>
+	{
+		using type = IndexSequence<I...>;
+	};
+
+	static constexpr double validatedSum(const double (&characteristics)[N], size_t i, double sum)
+	{
+		return i == N ? (sum == 0 ? throw std::runtime_error("Invalid FlowCharacteristics. All array elements can't be 0.") : sum)
+					  : (characteristics[i] < 0 ? throw std::runtime_error("Invalid FlowCharacteristics") : validatedSum(characteristics, i + 1, sum + characteristics[i]));
+	}
+
+	static constexpr double normalizedSum(const double (&characteristics)[N], double multiplier, size_t until, size_t i = 0, double sum = 0)
+	{
+		return i == until ? sum : normalizedSum(characteristics, multiplier, until, i + 1, sum + characteristics[i] * multiplier);
+	}
+
+	static constexpr size_t zeroBuckets(const double (&characteristics)[N], double multiplier, size_t i)
+	{
+		return i == N ? 0 : (characteristics[i] * multiplier < Flow::ZERO_BUCKET_DELTA ? 1 : 0) + zeroBuckets(characteristics, multiplier, i + 1);
+	}
+
+	template <size_t... I, size_t... J>
+	static constexpr FlowTemplate build(const double (&characteristics)[N], double multiplier, IndexSequence<I...>, IndexSequence<J...>)
+	{
+		return FlowTemplate{{{characteristics[I] * multiplier...}}, {{normalizedSum(characteristics, multiplier, J)...}}, zeroBuckets(characteristics, multiplier, 0)};
 	}
 };
 
-} // namespace NaturalMouseMotion
\ No newline at end of file
+} // namespace NaturalMouseMotion
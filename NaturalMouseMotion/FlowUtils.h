@@ -4,6 +4,7 @@
 #include <functional>
 #include <algorithm>
 #include <stdexcept>
+#include <cstddef>
 #include "Flow.h"
 
 namespace NaturalMouseMotion
@@ -62,59 +63,146 @@ struct FlowUtils
      * with array size of 6, simplistic solutions quickly would run to trouble like this  [1, 1.5, 2, 2.5, 3, (3)? ]
      * or maybe: [1, 1.5, 2, 2.5, ..., 3 ]. The correct solution would correctly scale the middle numbers
      * over several indexes.
+     *
+     * The flow is conceptually stretched to a length where the original values are evenly spaced, filling
+     * the gaps with linear interpolation, and then reduced to targetLength. Both steps are done at once
+     * from running sums of the interpolated array, so time is O(flowLength + targetLength) and no
+     * intermediate array is built.
      * @param flow the original flow
+     * @param flowLength the original flow length
+     * @param result receives the resulting flow, must have room for targetLength values
      * @param targetLength the resulting flow length
-     * @param modifier modifies the resulting values, you can use this to provide noise or amplify
-     *                 the flow characteristics.
-     * @return the resulting flow
      */
-    static FlowCharacteristicsContainer stretchFlow(FlowCharacteristicsContainer flow, size_t targetLength, FlowModifierFunc modifier = nullptr)
+    static void stretchFlow(const double *flow, size_t flowLength, double *result, size_t targetLength)
     {
-        if (targetLength < flow.size())
+        if (flowLength == 0)
+        {
+            throw std::runtime_error("Bad arguments");
+        }
+        if (targetLength < flowLength)
         {
             throw std::runtime_error("Target bucket length smaller than flow.");
         }
 
-        size_t tempLength = targetLength;
-
-        if (flow.size() != 1 && (tempLength - flow.size()) % (flow.size() - 1) != 0)
+        if (flowLength == 1)
         {
-            tempLength = (flow.size() - 1) * (tempLength - flow.size()) + 1;
+            std::fill(result, result + targetLength, flow[0]);
+            return;
         }
 
-        FlowCharacteristicsContainer result(tempLength);
-        int insider = static_cast<int>(flow.size()) - 2;
-        int stepLength = (int)((tempLength - 2) / (double)(insider + 1)) + 1;
-        int countToNextStep = stepLength;
-        size_t fillValueIndex = 0;
-        for (size_t i = 0; i < tempLength; i++)
+        // Length of the evenly spaced array, each original value is followed by segmentLength - 1 interpolated ones
+        size_t tempLength = targetLength;
+        if ((tempLength - flowLength) % (flowLength - 1) != 0)
         {
-            double fillValueBottom = flow[fillValueIndex];
-            double fillValueTop = fillValueIndex + 1 < flow.size() ? flow[fillValueIndex + 1] : flow[fillValueIndex];
-
-            double completion = (stepLength - countToNextStep) / (double)stepLength;
+            tempLength = (flowLength - 1) * (tempLength - flowLength) + 1;
+        }
+        const size_t segmentLength = (tempLength - 1) / (flowLength - 1);
 
-            result[i] = fillValueBottom * (1 - completion) + fillValueTop * completion;
+        auto interpolated = [&](size_t index) -> double {
+            size_t segment = index / segmentLength;
+            double completion = (index % segmentLength) / (double)segmentLength;
+            double bottom = flow[segment];
+            double top = segment + 1 < flowLength ? flow[segment + 1] : flow[segment];
+            return bottom * (1 - completion) + top * completion;
+        };
 
-            countToNextStep--;
+        if (tempLength == targetLength)
+        {
+            for (size_t i = 0; i < targetLength; i++)
+            {
+                result[i] = interpolated(i);
+            }
+            return;
+        }
 
-            if (countToNextStep == 0)
+        // Sum of the interpolated array up to (fractional) position, positions must be queried in increasing order.
+        size_t segment = 0;
+        double segmentStartSum = 0;
+        auto sumUntil = [&](double position) -> double {
+            if (position >= tempLength)
+            {
+                position = static_cast<double>(tempLength);
+            }
+            auto index = static_cast<size_t>(position);
+            size_t targetSegment = std::min(index / segmentLength, flowLength - 1);
+            for (; segment < targetSegment; segment++)
+            {
+                double bottom = flow[segment];
+                double top = flow[segment + 1];
+                segmentStartSum += segmentLength * bottom + (top - bottom) * (segmentLength - 1) / 2.0;
+            }
+            double bottom = flow[segment];
+            double top = segment + 1 < flowLength ? flow[segment + 1] : flow[segment];
+            double count = static_cast<double>(index - segment * segmentLength);
+            double sum = segmentStartSum + count * bottom + (top - bottom) * count * (count - 1) / (2.0 * segmentLength);
+            if (index < tempLength)
             {
-                countToNextStep = stepLength;
-                fillValueIndex++;
+                sum += (position - index) * interpolated(index);
             }
+            return sum;
+        };
+
+        double multiplier = targetLength / (double)tempLength;
+        double previousSum = 0;
+        for (size_t i = 0; i < targetLength; i++)
+        {
+            double sum = sumUntil((i + 1) * (double)tempLength / targetLength);
+            result[i] = (sum - previousSum) * multiplier;
+            previousSum = sum;
         }
+    }
 
-        if (tempLength != targetLength)
+    /**
+     * @see stretchFlow(const double*, size_t, double*, size_t)
+     * @param modifier modifies the resulting values, you can use this to provide noise or amplify
+     *                 the flow characteristics. Called with every resulting value as double&.
+     */
+    template <typename Modifier>
+    static void stretchFlow(const double *flow, size_t flowLength, double *result, size_t targetLength, Modifier modifier)
+    {
+        stretchFlow(flow, flowLength, result, targetLength);
+        for (size_t i = 0; i < targetLength; i++)
         {
-            result = reduceFlow(result, targetLength);
+            modifier(result[i]);
         }
+    }
+
+    /**
+     * @see stretchFlow(const double*, size_t, double*, size_t)
+     * @param flow the original flow
+     * @param targetLength the resulting flow length
+     * @return the resulting flow
+     */
+    static FlowCharacteristicsContainer stretchFlow(const FlowCharacteristicsContainer &flow, size_t targetLength)
+    {
+        FlowCharacteristicsContainer result(targetLength);
+        stretchFlow(flow.data(), flow.size(), result.data(), targetLength);
+        return result;
+    }
 
+    /**
+     * @see stretchFlow(const double*, size_t, double*, size_t, Modifier)
+     */
+    template <typename Modifier>
+    static FlowCharacteristicsContainer stretchFlow(const FlowCharacteristicsContainer &flow, size_t targetLength, Modifier modifier)
+    {
+        FlowCharacteristicsContainer result(targetLength);
+        stretchFlow(flow.data(), flow.size(), result.data(), targetLength, modifier);
+        return result;
+    }
+
+    static FlowCharacteristicsContainer stretchFlow(const FlowCharacteristicsContainer &flow, size_t targetLength, const FlowModifierFunc &modifier)
+    {
         if (modifier)
         {
-            std::for_each(result.begin(), result.end(), modifier);
+            return stretchFlow<const FlowModifierFunc &>(flow, targetLength, modifier);
         }
-        return result;
+        return stretchFlow(flow, targetLength);
+    }
+
+    static FlowCharacteristicsContainer stretchFlow(const FlowCharacteristicsContainer &flow, size_t targetLength, std::nullptr_t)
+    {
+        return stretchFlow(flow, targetLength);
     }
 };
 } // namespace NaturalMouseMotion
@@ -0,0 +1,275 @@
+#pragma once
+
+/**
+ * Backend writing kernel input events to a file descriptor, a uinput device or anything else taking
+ * struct input_event records. Linux only.
+ */
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DefaultProvider.h"
+
+namespace NaturalMouseMotion
+{
+namespace DefaultProvider
+{
+
+/**
+ * Moves the pointer by writing input events, EV_ABS or EV_REL positions each followed by a SYN_REPORT,
+ * without a display server. Works on headless and Wayland hosts through uinput, and into a pipe or a file
+ * for whatever reads them back.
+ * Events are queued and written when playback is about to wait for the next step deadline, every queued
+ * step going out with one write.
+ * The cursor can't be read back, getMousePosition is the position last set, starting at the start position
+ * given on construction. Relative motion is the difference from it, so in Relative mode it has to be where the
+ * compositor has the cursor, every target is off by the difference otherwise.
+ */
+struct InputEventSystemCalls final : public SystemCalls
+{
+	enum class Mode
+	{
+		/**
+		 * ABS_X and ABS_Y in [0, screen size), the device is a tablet-like pointer mapped to the screen
+		 */
+		Absolute,
+		/**
+		 * REL_X and REL_Y from the last position, pointer acceleration of the compositor still applies
+		 */
+		Relative
+	};
+
+	/**
+	 * Creates a uinput pointer device and writes to it, the device is destroyed with this.
+	 * Needs write access to /dev/uinput.
+	 * @param start where the cursor is, relative motion starts from it
+	 * @param name the device name shown to the compositor
+	 */
+	InputEventSystemCalls(Dimension screenSize, Mode mode, Point<int> start, const char *name = "NaturalMouseMotion")
+		: InputEventSystemCalls(OpenUinput(screenSize, mode, name), screenSize, mode, start)
+	{
+		ownsDescriptor = true;
+	}
+
+	/**
+	 * Absolute uinput pointer device starting at (0, 0), the first step puts the cursor where it is aimed at
+	 */
+	explicit InputEventSystemCalls(Dimension screenSize, const char *name = "NaturalMouseMotion")
+		: InputEventSystemCalls(screenSize, Mode::Absolute, {0, 0}, name)
+	{
+	}
+
+	/**
+	 * Writes to a descriptor opened by the caller, which stays open after this
+	 * @param start where the cursor is, relative motion starts from it
+	 */
+	InputEventSystemCalls(int fd, Dimension screenSize, Mode mode, Point<int> start) : fd(fd), screenSize(screenSize), mode(mode), position(start)
+	{
+		// A position and its SYN_REPORT, times a generous number of steps queued before a wait
+		pending.reserve(3 * 64);
+	}
+
+	/**
+	 * Absolute positions to a descriptor opened by the caller, starting at (0, 0)
+	 */
+	InputEventSystemCalls(int fd, Dimension screenSize) : InputEventSystemCalls(fd, screenSize, Mode::Absolute, {0, 0})
+	{
+	}
+
+	~InputEventSystemCalls()
+	{
+		try
+		{
+			flush();
+		}
+		catch (const std::runtime_error &)
+		{
+		}
+		if (ownsDescriptor)
+		{
+			ioctl(fd, UI_DEV_DESTROY);
+			close(fd);
+		}
+	}
+
+	InputEventSystemCalls(const InputEventSystemCalls &) = delete;
+	InputEventSystemCalls &operator=(const InputEventSystemCalls &) = delete;
+
+	Dimension getScreenSize() override
+	{
+		return screenSize;
+	}
+
+	void setMousePosition(int x, int y) override
+	{
+		// uinput stamps the events itself, other readers get the time they were queued at
+		queueTime = SteadyClock::Nanos();
+		if (mode == Mode::Absolute)
+		{
+			queue(EV_ABS, ABS_X, x);
+			queue(EV_ABS, ABS_Y, y);
+		}
+		else
+		{
+			if (x != position.x)
+			{
+				queue(EV_REL, REL_X, x - position.x);
+			}
+			if (y != position.y)
+			{
+				queue(EV_REL, REL_Y, y - position.y);
+			}
+		}
+		queue(EV_SYN, SYN_REPORT, 0);
+		position = {x, y};
+	}
+
+	Point<int> getMousePosition() override
+	{
+		return position;
+	}
+
+	time_type currentTimeMillis() override
+	{
+		return SteadyClock::Nanos() / NANOS_IN_MILLI;
+	}
+
+	void sleep(time_type time) override
+	{
+		flush();
+		std::this_thread::sleep_for(std::chrono::milliseconds(time));
+	}
+
+	time_type currentTimeNanos() override
+	{
+		return SteadyClock::Nanos();
+	}
+
+	void sleepNanos(time_type nanos) override
+	{
+		flush();
+		SteadyClock::SleepNanos(nanos, spinNanos);
+	}
+
+	void sleepUntilNanos(time_type deadline) override
+	{
+		flush();
+		SteadyClock::SleepUntilNanos(deadline, spinNanos);
+	}
+
+	/**
+	 * Writes the queued events
+	 * @throws std::runtime_error when the descriptor doesn't take them
+	 */
+	void flush()
+	{
+		if (pending.empty())
+		{
+			return;
+		}
+		auto data = reinterpret_cast<const char *>(pending.data());
+		size_t left = pending.size() * sizeof(input_event);
+		while (left > 0)
+		{
+			auto written = write(fd, data, left);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				pending.clear();
+				throw std::runtime_error(std::string("Can't write input events: ") + std::strerror(errno));
+			}
+			data += written;
+			left -= written;
+		}
+		pending.clear();
+		writes++;
+	}
+
+	/**
+	 * @return how many times queued events were written
+	 */
+	uint64_t getWrites() const
+	{
+		return writes;
+	}
+
+	/**
+	 * Part of every step wait that is spun, trading CPU time for accurate step timing
+	 */
+	time_type spinNanos{SteadyClock::DEFAULT_SPIN_NANOS};
+
+private:
+	int fd;
+	bool ownsDescriptor{false};
+	Dimension screenSize;
+	Mode mode;
+	Point<int> position;
+	std::vector<input_event> pending{};
+	time_type queueTime{0};
+	uint64_t writes{0};
+
+	void queue(unsigned short type, unsigned short code, int value)
+	{
+		input_event event{};
+		event.input_event_sec = static_cast<decltype(event.input_event_sec)>(queueTime / (1000 * NANOS_IN_MILLI));
+		event.input_event_usec = static_cast<decltype(event.input_event_usec)>(queueTime % (1000 * NANOS_IN_MILLI) / 1000);
+		event.type = type;
+		event.code = code;
+		event.value = value;
+		pending.push_back(event);
+	}
+
+	static int OpenUinput(Dimension screenSize, Mode mode, const char *name)
+	{
+		int fd = open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+		if (fd < 0)
+		{
+			throw std::runtime_error(std::string("Can't open /dev/uinput: ") + std::strerror(errno));
+		}
+		// A button makes the device a pointer rather than a joystick to libinput
+		bool ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0 && ioctl(fd, UI_SET_KEYBIT, BTN_LEFT) == 0;
+		if (mode == Mode::Absolute)
+		{
+			ok = ok && ioctl(fd, UI_SET_EVBIT, EV_ABS) == 0 && ioctl(fd, UI_SET_ABSBIT, ABS_X) == 0 && ioctl(fd, UI_SET_ABSBIT, ABS_Y) == 0;
+			uinput_abs_setup abs{};
+			abs.code = ABS_X;
+			abs.absinfo.maximum = screenSize.Width - 1;
+			ok = ok && ioctl(fd, UI_ABS_SETUP, &abs) == 0;
+			abs.code = ABS_Y;
+			abs.absinfo.maximum = screenSize.Height - 1;
+			ok = ok && ioctl(fd, UI_ABS_SETUP, &abs) == 0;
+		}
+		else
+		{
+			ok = ok && ioctl(fd, UI_SET_EVBIT, EV_REL) == 0 && ioctl(fd, UI_SET_RELBIT, REL_X) == 0 && ioctl(fd, UI_SET_RELBIT, REL_Y) == 0;
+		}
+		uinput_setup setup{};
+		setup.id.bustype = BUS_VIRTUAL;
+		std::strncpy(setup.name, name, UINPUT_MAX_NAME_SIZE - 1);
+		ok = ok && ioctl(fd, UI_DEV_SETUP, &setup) == 0 && ioctl(fd, UI_DEV_CREATE) == 0;
+		if (!ok)
+		{
+			auto error = errno;
+			close(fd);
+			throw std::runtime_error(std::string("Can't create the uinput device: ") + std::strerror(error));
+		}
+		return fd;
+	}
+};
+
+} // namespace DefaultProvider
+} // namespace NaturalMouseMotion
+
+#endif
@@ -3,7 +3,7 @@
 #include <memory>
 #include <string>
 #include <cstdarg>
-#include <list>
+#include <cstdio>
 #include <functional>
 
 namespace NaturalMouseMotion
@@ -13,18 +13,20 @@ using LoggerPrinterFunc = std::function<void(const std::string)>;
 
 struct Logger
 {
-    static void Print(LoggerPrinterFunc printer, const std::string fmt, ...)
+    /**
+     * Formats and prints the message, does nothing but check the printer when it isn't set.
+     * Messages up to 255 characters are formatted on the stack.
+     */
+    static void Print(const LoggerPrinterFunc &printer, const char *fmt, ...)
     {
         if (!printer)
             return;
 
-        std::string formated;
-
         char buf[256];
 
         va_list args;
         va_start(args, fmt);
-        const auto r = std::vsnprintf(buf, sizeof buf, fmt.c_str(), args);
+        const auto r = std::vsnprintf(buf, sizeof buf, fmt, args);
         va_end(args);
 
         if (r < 0)
@@ -34,30 +36,17 @@ struct Logger
         const size_t len = r;
         if (len < sizeof buf)
         {
-            formated = buf;
+            printer(std::string(buf, len));
         }
         else
         {
-    #if __cplusplus >= 201703L
-            // C++17: Create a string and write to its underlying array
-            std::string s(len, '\0');
+            std::string formated(len, '\0');
             va_start(args, fmt);
-            std::vsnprintf(s.data(), len + 1, fmt, args);
+            std::vsnprintf(&formated[0], len + 1, fmt, args);
             va_end(args);
 
-            formated = s;
-    #else
-            // C++11 or C++14: We need to allocate scratch memory
-            auto vbuf = std::unique_ptr<char[]>(new char[len + 1]);
-            va_start(args, fmt);
-            std::vsnprintf(vbuf.get(), len + 1, fmt.c_str(), args);
-            va_end(args);
-
-            formated = vbuf.get();
-    #endif
+            printer(formated);
         }
-
-        printer(formated);
     }
 };
 } // namespace NaturalMouseMotion
\ No newline at end of file
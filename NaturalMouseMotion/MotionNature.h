@@ -4,41 +4,137 @@
 #include <functional>
 #include <random>
 #include <memory>
+#include <type_traits>
 
 #include "Flow.h"
 #include "Logger.h"
+#include "MovementSteps.h"
+#include "PlaybackStats.h"
+#include "ScreenLayout.h"
 
 namespace NaturalMouseMotion
 {
 
 /**
- * Type used for screen dimensions
+ * Type used for milliseconds, and nanoseconds where noted
  **/
-struct Dimension
-{
-	int Width;
-	int Height;
-};
+using time_type = int64_t;
+
+static constexpr time_type NANOS_IN_MILLI{1000000};
 
 /**
- * Simple coordinates type
- **/
-template<typename T>
-struct Point
+ * Draws several values from a source of randomness at once
+ */
+struct RandomFill
 {
-	T x;
-	T y;
+	/**
+	 * Draws n values at once, the same values n calls would return.
+	 * Generators with a fill(double *out, size_t n) method are used directly.
+	 */
+	template <typename Random>
+	static void Fill(Random &random, double *out, size_t n)
+	{
+		Fill(random, out, n, 0);
+	}
+
+private:
+	template <typename Random>
+	static auto Fill(Random &random, double *out, size_t n, int) -> decltype(random.fill(out, n), void())
+	{
+		random.fill(out, n);
+	}
+
+	template <typename Random>
+	static void Fill(Random &random, double *out, size_t n, long)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			out[i] = random();
+		}
+	}
 };
 
 /**
- * Type used for milliseconds
- **/
-using time_type = int64_t;
+ * Shared stream of randomness, each call returns a double between 0.0 and 1.0.
+ * Can be constructed from any callable returning such doubles, e.g. DefaultProvider::DefaultRandomProvider.
+ * Copies refer to the same generator, so every component holding a copy draws from, and advances,
+ * the same sequence and copying never duplicates generator state. Not thread safe.
+ */
+class RandomStream
+{
+public:
+	RandomStream() = default;
+
+	template <typename Generator, typename = typename std::enable_if<!std::is_same<typename std::decay<Generator>::type, RandomStream>::value>::type>
+	RandomStream(Generator generator) : source(std::make_shared<Source<Generator>>(std::move(generator)))
+	{
+	}
+
+	double operator()() const
+	{
+		return source->next();
+	}
+
+	/**
+	 * Draws n values at once, the same values n calls would return.
+	 * Generators with a fill(double *out, size_t n) method are used directly.
+	 */
+	void fill(double *out, size_t n) const
+	{
+		source->fill(out, n);
+	}
+
+	explicit operator bool() const
+	{
+		return source != nullptr;
+	}
+
+	/**
+	 * Access to the generator the stream was constructed from, e.g. to re-key a CounterRandomProvider.
+	 * @return the generator, or nullptr if the stream holds a generator of another type
+	 */
+	template <typename Generator>
+	Generator *target() const
+	{
+		auto typed = dynamic_cast<Source<Generator> *>(source.get());
+		return typed ? &typed->generator : nullptr;
+	}
+
+private:
+	struct SourceBase
+	{
+		virtual ~SourceBase() = default;
+		virtual double next() = 0;
+		virtual void fill(double *out, size_t n) = 0;
+	};
+
+	template <typename Generator>
+	struct Source : SourceBase
+	{
+		Source(Generator generator) : generator(std::move(generator))
+		{
+		}
+
+		double next() override
+		{
+			return generator();
+		}
+
+		void fill(double *out, size_t n) override
+		{
+			RandomFill::Fill(generator, out, n);
+		}
+
+		Generator generator;
+	};
+
+	std::shared_ptr<SourceBase> source;
+};
 
 /*
  * Return a double between 0.0 and 1.0
  */
-using RandomZeroToOneFunc = std::function<double()>;
+using RandomZeroToOneFunc = RandomStream;
 
 
 /**
@@ -59,13 +155,13 @@ using MouseMotionObserverFunc = std::function<void(int x, int y)>;
  * During the final steps of mouse movement, the effect of noise is gradually reduced, so the mouse
  * would finish on the intended pixel smoothly, thus the implementation of this class can safely ignore
  * and not know the beginning and end of the movement.
- * @param random use this to generate randomness in the offset
+ * @param random use this to generate randomness in the offset, it is the stream of the nature passed by reference
  * @param xStepSize the step size that is taken horizontally
  * @param yStepSize the step size that is taken vertically
  * @return a point which describes how much the mouse offset is increased or decreased this step.
  * This value must not include the parameters xStepSize and yStepSize. For no change in noise just return (0,0).
  */
-using GetNoiseFunc = std::function<Point<double>(RandomZeroToOneFunc random, double xStepSize, double yStepSize)>;
+using GetNoiseFunc = std::function<Point<double>(const RandomStream &random, double xStepSize, double yStepSize)>;
 
 
 /**
@@ -155,9 +251,173 @@ struct SystemCalls
 	virtual Dimension getScreenSize() = 0;
 	virtual void setMousePosition(int x, int y) = 0;
 	virtual Point<int> getMousePosition() = 0;
+
+	/**
+	 * Whether the cursor was moved by something other than setMousePosition, usually the user, since the last call
+	 * or since watching started. Asked after every step when the nature reacts to interference, so it must not wait
+	 * for the server.
+	 * Defaults to never noticing; interference then only shows when a movement doesn't end where it was aimed at.
+	 */
+	virtual bool takeForeignMotion()
+	{
+		return false;
+	}
+
+	/**
+	 * Called with true before the first step of a move that reacts to interference and with false after its last,
+	 * calls nest. Foreign motion only has to be gathered while watched, motion from before is discarded.
+	 * Defaults to doing nothing.
+	 */
+	virtual void watchForeignMotion(bool /* watching */)
+	{
+	}
+
+	/**
+	 * The monitors of the screen, targets and paths are kept to the parts of the screen they show.
+	 * Asked once per move, which keeps the layout for as long as it plays, also on other threads.
+	 * Defaults to a new single monitor of getScreenSize every call; override to hand out the same layout
+	 * while it doesn't change, so moves don't allocate for it.
+	 */
+	virtual std::shared_ptr<const ScreenLayout> getScreenLayout()
+	{
+		return std::make_shared<const ScreenLayout>(getScreenSize());
+	}
+
+	/**
+	 * Monotonic time in nanoseconds, used to pace the steps of a movement. Only differences are meaningful.
+	 * Defaults to currentTimeMillis, override for sub-millisecond pacing.
+	 */
+	virtual time_type currentTimeNanos()
+	{
+		return currentTimeMillis() * NANOS_IN_MILLI;
+	}
+
+	/**
+	 * Waits for the given nanoseconds, as precisely as the system allows.
+	 * Defaults to sleep, rounding up to whole milliseconds.
+	 */
+	virtual void sleepNanos(time_type nanos)
+	{
+		sleep((nanos + NANOS_IN_MILLI - 1) / NANOS_IN_MILLI);
+	}
+
+	/**
+	 * Waits until currentTimeNanos reaches deadline, returns immediately if it already has.
+	 * Defaults to sleepNanos for the time left, override to sleep to the absolute deadline.
+	 */
+	virtual void sleepUntilNanos(time_type deadline)
+	{
+		auto timeLeft = deadline - currentTimeNanos();
+		if (timeLeft > 0)
+		{
+			sleepNanos(timeLeft);
+		}
+	}
 };
 
-struct MotionNature
+/**
+ * What a move does when SystemCalls::takeForeignMotion reports that the cursor was moved during playback
+ */
+enum class InterferencePolicy
+{
+	/**
+	 * Isn't asked, the movement plays on
+	 */
+	Ignore,
+	/**
+	 * The move stops where the cursor was moved to
+	 */
+	Abort,
+	/**
+	 * The rest of the movement is dropped and the move is planned again from where the cursor was moved to
+	 */
+	Replan
+};
+
+/**
+ * Settings for the thread playing back a move, applied only while the move plays and restored afterwards.
+ * Reduces stalls from preemption on busy hosts. Settings that can't be applied, usually for lack of
+ * permissions, are skipped and reported in PlaybackStats::realtime and the info log.
+ * Supported on Linux, elsewhere every setting is reported as failed.
+ */
+struct RealtimeConfig
+{
+	enum class Scheduling
+	{
+		Unchanged,
+		Fifo,
+		RoundRobin
+	};
+
+	/**
+	 * Real-time scheduling policy and its priority, needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowing the priority
+	 */
+	Scheduling scheduling{Scheduling::Unchanged};
+	int priority{1};
+
+	/**
+	 * Pins the thread to this CPU when 0 or above
+	 */
+	int cpu{-1};
+
+	/**
+	 * Places the step buffers in memory of their own for lockedSteps steps and locks it, limited by
+	 * RLIMIT_MEMLOCK. While it is locked a movement takes at most lockedSteps steps, longer ones take longer steps.
+	 */
+	bool lockMemory{false};
+	int lockedSteps{1024};
+
+	/**
+	 * Sets the timer slack of the thread to its minimum, so sleeps aren't extended to be coalesced
+	 */
+	bool minimalTimerSlack{false};
+
+	bool enabled() const
+	{
+		return scheduling != Scheduling::Unchanged || cpu >= 0 || lockMemory || minimalTimerSlack;
+	}
+};
+
+/**
+ * Access to a provider held by a nature, whether the nature holds it by value or through a pointer.
+ */
+template <typename T>
+T &Deref(T &provider)
+{
+	return provider;
+}
+
+template <typename T>
+T &Deref(T *provider)
+{
+	return *provider;
+}
+
+template <typename T>
+T &Deref(std::shared_ptr<T> &provider)
+{
+	return *provider;
+}
+
+template <typename T>
+T &Deref(const std::shared_ptr<T> &provider)
+{
+	return *provider;
+}
+
+/**
+ * Nature with every provider as a template parameter, so calls to concrete providers can be inlined.
+ * MotionNature is the instantiation using type erased providers, any of which can be replaced at runtime.
+ *
+ * @tparam Noise callable as GetNoiseFunc, receiving the random member
+ * @tparam Deviation callable as GetDeviationFunc
+ * @tparam Speed callable as GetFlowWithTimeFunc
+ * @tparam Overshoot OvershootManager implementation, held by value or pointer
+ * @tparam Sys SystemCalls implementation, held by value or pointer
+ * @tparam Rng callable returning doubles between 0.0 and 1.0
+ */
+template <typename Noise, typename Deviation, typename Speed, typename Overshoot, typename Sys, typename Rng>
+struct BasicMotionNature
 {
 	/**
 	 * Loggers accosiated with nature
@@ -173,8 +433,9 @@ struct MotionNature
 	/**
 	 * Source of randomness
 	 * This function must provide doubles in the range 0.0 to 1.0
+	 * Providers that need randomness should be given this stream, so all of them advance the same sequence.
 	 */
-	RandomZeroToOneFunc random;
+	Rng random;
 
 	/**
 	 * Time to steps is how NaturalMouseMotion calculates how many locations need to be visited between
@@ -213,28 +474,66 @@ struct MotionNature
 	/**
 	 * Provider to defines how the MouseMotion trajectory is being deviated or arced.
 	 */
-	GetDeviationFunc getDeviation;
+	Deviation getDeviation;
 
 	/**
 	 * Provides random mistakes in the trajectory of the moving mouse.
 	 */
-	GetNoiseFunc getNoise;
+	Noise getNoise;
 
 	/**
 	 * Overshoots provide a realistic way to simulate user trying to reach the destination with mouse, but miss.
 	 */
-	std::shared_ptr<OvershootManager> overshootManager;
+	Overshoot overshootManager;
 
 	/**
 	 * System call interface
 	 */
-	std::shared_ptr<SystemCalls> systemCalls;
+	Sys systemCalls;
 
 	/**
 	 * SpeedManager controls how long does it take to complete a movement and within that
 	 * time how slow or fast the cursor is moving at a particular moment, the flow of movement.
 	 */
-	GetFlowWithTimeFunc getFlowWithTime;
+	Speed getFlowWithTime;
+
+	/**
+	 * When a step wakes up late, jump to the step planned for the current time instead of playing back
+	 * every step in sequence. Keeps the movement time faithful to the plan when the system is loaded,
+	 * at the cost of skipping positions. The last step of a movement is never dropped.
+	 */
+	bool dropLateSteps{false};
+
+	/**
+	 * When above 0, movements are planned with one step per tick of this rate instead of using timeToStepsDivider
+	 * and minSteps, e.g. the display refresh rate or the input polling rate. Steps start on the ticks, counted from
+	 * the start of the movement, and the last one ends with the movement. Movements still never have more steps
+	 * than pixels travelled, steps then span several ticks each.
+	 */
+	double emissionRateHz{0};
+
+	/**
+	 * Real-time settings for the thread playing back moves, disabled by default
+	 */
+	RealtimeConfig realtime{};
+
+	/**
+	 * What a move does when the cursor is moved by something else while it plays back, see SystemCalls::takeForeignMotion.
+	 * Move, MoveCoroutine and MotionStepper, and so MotionSimulator, follow it; MovePipeline replans like it aborts.
+	 */
+	InterferencePolicy onInterference{InterferencePolicy::Ignore};
+
+	/**
+	 * Receives playback statistics when set
+	 */
+	std::shared_ptr<PlaybackStats> stats{};
+
+	/**
+	 * Reused by the moves of this nature, see StepBuffers
+	 */
+	StepBuffers stepBuffers{};
 };
 
+using MotionNature = BasicMotionNature<GetNoiseFunc, GetDeviationFunc, GetFlowWithTimeFunc, std::shared_ptr<OvershootManager>, std::shared_ptr<SystemCalls>, RandomStream>;
+
 } // namespace NaturalMouseMotion
\ No newline at end of file
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "DefaultProvider.h"
+#include "MotionStepper.h"
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * What a simulation run did
+ */
+struct SimulationReport
+{
+	uint64_t pointers{0};
+	uint64_t moves{0};
+	uint64_t steps{0};
+	/**
+	 * Time that passed for the pointers, from the start until the last one finished
+	 */
+	time_type simulatedNanos{0};
+	time_type wallNanos{0};
+
+	double stepsPerSecond() const
+	{
+		return wallNanos > 0 ? steps * 1.0e9 / wallNanos : 0;
+	}
+
+	/**
+	 * @return how many times faster than real time the pointers moved
+	 */
+	double speedup() const
+	{
+		return wallNanos > 0 ? simulatedNanos / (double)wallNanos : 0;
+	}
+};
+
+/**
+ * Moves many virtual pointers at the same time on a few threads, each pointer with a nature of its own that
+ * emits into its own SystemCalls. Pointers are spread over the threads, every thread keeps a heap of the
+ * pointers' next deadlines and advances the earliest one.
+ * In virtual time the clock jumps from deadline to deadline, so pointers move as fast as the threads can plan
+ * and emit; in real time the threads sleep until each deadline, to feed consumers at the rate real pointers would.
+ */
+template <typename Nature>
+class BasicMotionSimulator
+{
+public:
+	struct Options
+	{
+		int threads{1};
+		bool realTime{false};
+	};
+
+	explicit BasicMotionSimulator(Options options = Options{}) : options(options)
+	{
+	}
+
+	/**
+	 * @param nature moves the pointer and receives its positions, must outlive the run and not be shared between pointers
+	 * @param targets the pointer moves to each in turn, one Move after the other
+	 * @return the index of the pointer
+	 */
+	size_t addPointer(Nature &nature, std::vector<Point<int>> targets)
+	{
+		pointers.emplace_back(new Pointer(nature, std::move(targets)));
+		return pointers.size() - 1;
+	}
+
+	size_t getPointerCount() const
+	{
+		return pointers.size();
+	}
+
+	/**
+	 * Moves every pointer through its targets, blocks until all have finished.
+	 * Rethrows the first failure of a pointer, after every thread has stopped.
+	 */
+	SimulationReport run()
+	{
+		auto threads = std::max(1, std::min(options.threads, (int)std::max<size_t>(pointers.size(), 1)));
+		std::vector<Shard> shards(threads);
+		for (size_t i = 0; i < pointers.size(); i++)
+		{
+			pointers[i]->reset();
+			shards[i % threads].pointers.push_back(pointers[i].get());
+		}
+
+		auto wallStart = DefaultProvider::SteadyClock::Nanos();
+		std::vector<std::thread> workers;
+		for (int i = 1; i < threads; i++)
+		{
+			workers.emplace_back([this, &shards, i, wallStart]() { runShard(shards[i], wallStart); });
+		}
+		runShard(shards[0], wallStart);
+		for (auto &worker : workers)
+		{
+			worker.join();
+		}
+
+		SimulationReport report;
+		report.wallNanos = DefaultProvider::SteadyClock::Nanos() - wallStart;
+		report.pointers = pointers.size();
+		for (auto &shard : shards)
+		{
+			if (shard.failure)
+			{
+				std::rethrow_exception(shard.failure);
+			}
+			report.simulatedNanos = std::max(report.simulatedNanos, shard.now);
+		}
+		for (auto &pointer : pointers)
+		{
+			report.moves += pointer->target;
+			report.steps += pointer->stepper.getEmittedSteps();
+		}
+		return report;
+	}
+
+private:
+	struct Pointer
+	{
+		BasicMotionStepper<Nature> stepper;
+		std::vector<Point<int>> targets;
+		size_t target{0};
+
+		Pointer(Nature &nature, std::vector<Point<int>> targets) : stepper(nature), targets(std::move(targets))
+		{
+		}
+
+		/**
+		 * Back to the first target, also when the last run stopped partway through a move
+		 */
+		void reset()
+		{
+			stepper.stop();
+			target = 0;
+		}
+
+		/**
+		 * @return when to advance again, FINISHED after the last target
+		 */
+		time_type advance(time_type now)
+		{
+			for (;;)
+			{
+				if (stepper.finished())
+				{
+					if (target == targets.size())
+					{
+						return BasicMotionStepper<Nature>::FINISHED;
+					}
+					stepper.moveTo(targets[target].x, targets[target].y);
+					target++;
+				}
+				auto deadline = stepper.advance(now);
+				if (deadline != BasicMotionStepper<Nature>::FINISHED)
+				{
+					return deadline;
+				}
+			}
+		}
+	};
+
+	struct Timer
+	{
+		time_type deadline;
+		uint64_t sequence;
+		Pointer *pointer;
+
+		bool operator>(const Timer &other) const
+		{
+			return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+		}
+	};
+
+	struct Shard
+	{
+		std::vector<Pointer *> pointers{};
+		// Simulated time since the start of the run
+		time_type now{0};
+		std::exception_ptr failure{};
+	};
+
+	Options options;
+	std::vector<std::unique_ptr<Pointer>> pointers{};
+
+	void runShard(Shard &shard, time_type wallStart)
+	{
+		try
+		{
+			std::vector<Timer> storage;
+			storage.reserve(shard.pointers.size());
+			std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers(std::greater<Timer>(), std::move(storage));
+			uint64_t sequence = 0;
+			for (auto pointer : shard.pointers)
+			{
+				timers.push({0, sequence++, pointer});
+			}
+			while (!timers.empty())
+			{
+				auto timer = timers.top();
+				timers.pop();
+				shard.now = std::max(shard.now, timer.deadline);
+				if (options.realTime)
+				{
+					DefaultProvider::SteadyClock::SleepUntilNanos(wallStart + timer.deadline);
+					// Late wake-ups show up as step lateness, like they would for a real pointer
+					shard.now = std::max(shard.now, DefaultProvider::SteadyClock::Nanos() - wallStart);
+				}
+				auto deadline = timer.pointer->advance(shard.now);
+				if (deadline != BasicMotionStepper<Nature>::FINISHED)
+				{
+					timers.push({deadline, sequence++, timer.pointer});
+				}
+			}
+		}
+		catch (...)
+		{
+			shard.failure = std::current_exception();
+		}
+	}
+};
+
+using MotionSimulator = BasicMotionSimulator<MotionNature>;
+
+} // namespace NaturalMouseMotion
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "Move.h"
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * MoveImp::Move as a state machine, for driving many motions from an event loop without a thread or a coroutine each.
+ * Every advance emits what is due and returns when the motion has to wait, with the time to advance it again.
+ * Emits the same positions at the same times as Move does with a clock that advances exactly to each deadline,
+ * and reacts to interference as Move does.
+ * Time is given by the caller, the nature's SystemCalls only set and read the cursor.
+ */
+template <typename Nature>
+class BasicMotionStepper
+{
+public:
+	/**
+	 * Returned by advance when the motion has finished
+	 */
+	static constexpr time_type FINISHED{std::numeric_limits<time_type>::max()};
+
+	/**
+	 * @param nature the nature that defines how mouse is moved, must outlive the stepper
+	 */
+	explicit BasicMotionStepper(Nature &nature) : nature(nature)
+	{
+	}
+
+	~BasicMotionStepper()
+	{
+		watch(false);
+	}
+
+	BasicMotionStepper(const BasicMotionStepper &) = delete;
+	BasicMotionStepper &operator=(const BasicMotionStepper &) = delete;
+
+	/**
+	 * Starts moving to the destination coordinates from whereever the cursor is, on the next advance
+	 */
+	void moveTo(int x, int y)
+	{
+		targetX = x;
+		targetY = y;
+		state = State::Start;
+	}
+
+	/**
+	 * @param now the current time in nanoseconds
+	 * @return when to advance again, FINISHED when the motion is done
+	 */
+	time_type advance(time_type now)
+	{
+		for (;;)
+		{
+			switch (state)
+			{
+			case State::Idle:
+				return FINISHED;
+			case State::Start:
+				start();
+				break;
+			case State::NextMovement:
+				if (mousePosition.x == xDest && mousePosition.y == yDest)
+				{
+					Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) completed", xDest, yDest);
+					finish();
+					return FINISHED;
+				}
+				plan(now);
+				break;
+			case State::Step:
+				if (playback.next < steps.steps)
+				{
+					auto played = MoveImp::PlayStep(nature, movement, steps, nullptr, playback, [now]() { return now; });
+					if (played == MoveImp::Playback::Interfered)
+					{
+						finishSteps(now);
+						if (!reactToInterference())
+						{
+							return FINISHED;
+						}
+						break;
+					}
+					auto deadline = playback.startTime + (time_type)steps.startOf(playback.next);
+					if (deadline > now)
+					{
+						return deadline;
+					}
+					break;
+				}
+				finishSteps(now);
+				if (!settle())
+				{
+					state = State::Settled;
+					return now + MoveImp::SLEEP_AFTER_ADJUSTMENT_MS * NANOS_IN_MILLI;
+				}
+				state = State::Settled;
+				break;
+			case State::Settled:
+				if (adjusted)
+				{
+					mousePosition = MoveImp::GetMousePosition(nature);
+				}
+				state = State::NextMovement;
+				if (mousePosition.x != xDest || mousePosition.y != yDest)
+				{
+					// We are dealing with overshoot, let's wait a bit to simulate human reaction time.
+					return now + (nature.reactionTimeBaseMs + (time_type)(nature.random() * (double)nature.reactionTimeVariationMs)) * NANOS_IN_MILLI;
+				}
+				break;
+			}
+		}
+	}
+
+	/**
+	 * Drops the motion in progress, e.g. after advance threw, and ends its watch.
+	 * The stepper is finished until the next moveTo.
+	 */
+	void stop()
+	{
+		movements.clear();
+		finish();
+	}
+
+	bool finished() const
+	{
+		return state == State::Idle;
+	}
+
+	uint64_t getEmittedSteps() const
+	{
+		return emittedSteps;
+	}
+
+private:
+	enum class State
+	{
+		Idle,
+		Start,
+		NextMovement,
+		Step,
+		Settled
+	};
+
+	Nature &nature;
+	State state{State::Idle};
+	int targetX{0};
+	int targetY{0};
+	int xDest{0};
+	int yDest{0};
+	std::shared_ptr<const ScreenLayout> layout{};
+	Point<int> mousePosition{0, 0};
+	MovementList movements{};
+	Movement movement{};
+	MovementSteps steps{};
+	MoveImp::StepPlayback playback{0, 0, 0};
+	bool adjusted{false};
+	// Whether mousePosition was just read, so planning doesn't have to ask again
+	bool mousePositionFresh{false};
+	// Whether foreign motion is being watched for, see SystemCalls::watchForeignMotion
+	bool watching{false};
+	uint64_t emittedSteps{0};
+
+	void start()
+	{
+		// Motion from before the move doesn't count as interference
+		watch(true);
+		layout = Deref(nature.systemCalls).getScreenLayout();
+		mousePosition = MoveImp::GetMousePosition(nature);
+		auto dest = layout->clamp({targetX, targetY});
+		xDest = dest.x;
+		yDest = dest.y;
+		Logger::Print(nature.info_printer, "Starting to move mouse to (%d, %d), current position: (%d, %d)", xDest, yDest, mousePosition.x, mousePosition.y);
+		movements = BasicMovementFactory<Nature>(nature, xDest, yDest, layout).createMovements(mousePosition);
+		mousePositionFresh = true;
+		state = State::NextMovement;
+	}
+
+	void plan(time_type now)
+	{
+		if (movements.empty())
+		{
+			mousePosition = MoveImp::GetMousePosition(nature);
+			Logger::Print(nature.debug_printer, "Re-populating movement array. Did not end up on target pixel.");
+			movements = BasicMovementFactory<Nature>(nature, xDest, yDest, layout).createMovements(mousePosition);
+			mousePositionFresh = true;
+		}
+		movement = movements.front();
+		movements.pop_front();
+		Logger::Print(nature.info_printer, "Movement arc length computed to %f and time predicted to %lld ms", movement.distance, (long long)movement.time);
+
+		if (!mousePositionFresh)
+		{
+			mousePosition = MoveImp::GetMousePosition(nature);
+		}
+		mousePositionFresh = false;
+		StepKernel::Plan(nature, movement, mousePosition, *layout, steps);
+		playback = MoveImp::StepPlayback{now, 0, 0};
+		state = State::Step;
+	}
+
+	void finishSteps(time_type now)
+	{
+		emittedSteps += playback.next - playback.droppedSteps;
+		MoveImp::FinishSteps(nature, steps, playback, [now]() { return now; });
+	}
+
+	/**
+	 * @return false when the move was aborted
+	 */
+	bool reactToInterference()
+	{
+		mousePosition = MoveImp::GetMousePosition(nature);
+		BasicMovementFactory<Nature> movementFactory(nature, xDest, yDest, layout);
+		if (!MoveImp::ReactToInterference(nature, movementFactory, mousePosition, {xDest, yDest}, movements, nullptr, 0))
+		{
+			finish();
+			return false;
+		}
+		mousePositionFresh = true;
+		state = State::NextMovement;
+		return true;
+	}
+
+	void finish()
+	{
+		state = State::Idle;
+		watch(false);
+	}
+
+	/**
+	 * Ends the current watch, and starts a new one when asked to and the nature reacts to interference
+	 */
+	void watch(bool start)
+	{
+		if (watching)
+		{
+			Deref(nature.systemCalls).watchForeignMotion(false);
+			watching = false;
+		}
+		if (start && nature.onInterference != InterferencePolicy::Ignore)
+		{
+			Deref(nature.systemCalls).watchForeignMotion(true);
+			watching = true;
+		}
+	}
+
+	/**
+	 * Puts the cursor on the endpoint of the movement if it didn't end up there, like MoveImp::SettleAt
+	 * @return true when it was there already
+	 */
+	bool settle()
+	{
+		mousePosition = MoveImp::GetMousePosition(nature);
+		adjusted = mousePosition.x != movement.destX || mousePosition.y != movement.destY;
+		if (adjusted)
+		{
+			Logger::Print(nature.info_printer, "Mouse off from step endpoint (adjustment was done) x:(%d -> %d) y:(%d -> %d)",
+				mousePosition.x, movement.destX, mousePosition.y, movement.destY);
+			MoveImp::SetMousePosition(nature, movement.destX, movement.destY);
+		}
+		return !adjusted;
+	}
+};
+
+template <typename Nature>
+constexpr time_type BasicMotionStepper<Nature>::FINISHED;
+
+using MotionStepper = BasicMotionStepper<MotionNature>;
+
+} // namespace NaturalMouseMotion
@@ -2,12 +2,104 @@
 
 #include "MotionNature.h"
 #include "MovementFactory.h"
+#include "StepKernel.h"
+#include "Realtime.h"
+
+#include <atomic>
 
 namespace NaturalMouseMotion
 {
+/**
+ * How far a move has got. Movements and steps count from 1, 0 means none has started yet.
+ */
+struct MoveProgress
+{
+    int movement;
+    int movements;
+    int step;
+    int steps;
+};
+
+/**
+ * Shared between a playing move and the threads observing it. Progress is published with relaxed stores,
+ * a snapshot taken while the move plays may mix values from neighbouring steps.
+ */
+struct MoveControl
+{
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> movement{0};
+    std::atomic<int> movements{0};
+    std::atomic<int> step{0};
+    std::atomic<int> steps{0};
+
+    void cancel()
+    {
+        cancelled.store(true);
+    }
+
+    bool isCancelled() const
+    {
+        return cancelled.load(std::memory_order_relaxed);
+    }
+
+    MoveProgress progress() const
+    {
+        return {movement.load(std::memory_order_relaxed), movements.load(std::memory_order_relaxed),
+                step.load(std::memory_order_relaxed), steps.load(std::memory_order_relaxed)};
+    }
+};
+
 struct MoveImp
 {
     static constexpr int SLEEP_AFTER_ADJUSTMENT_MS{2};
+    /**
+     * Longest a cancellable move sleeps without checking for cancellation, when waiting for reaction time
+     */
+    static constexpr int CANCEL_CHECK_MS{10};
+
+    /**
+     * How playing back the steps of a movement ended
+     */
+    enum class Playback
+    {
+        Completed,
+        Cancelled,
+        /**
+         * The cursor was moved by something else and the nature doesn't ignore it
+         */
+        Interfered
+    };
+
+    /**
+     * Watches for foreign motion for as long as it lives, when the nature reacts to it, see SystemCalls::watchForeignMotion
+     */
+    template <typename Nature>
+    class ForeignMotionWatch
+    {
+    public:
+        explicit ForeignMotionWatch(Nature& nature) : nature(nature), watching(nature.onInterference != InterferencePolicy::Ignore)
+        {
+            if (watching)
+            {
+                Deref(nature.systemCalls).watchForeignMotion(true);
+            }
+        }
+
+        ~ForeignMotionWatch()
+        {
+            if (watching)
+            {
+                Deref(nature.systemCalls).watchForeignMotion(false);
+            }
+        }
+
+        ForeignMotionWatch(const ForeignMotionWatch &) = delete;
+        ForeignMotionWatch &operator=(const ForeignMotionWatch &) = delete;
+
+    private:
+        Nature& nature;
+        bool watching;
+    };
 
     /**
     * Move cursor smoothly to the destination coordinates from whereever the cursor currently is.
@@ -16,156 +108,360 @@ struct MoveImp
     * @param nature the nature that defines how mouse is moved
     * @param xDest  the x-coordinate of destination
     * @param yDest  the y-coordinate of destination
+    * @param control receives the progress and is checked for cancellation before every step, may be nullptr.
+    *                A cancelled move returns wherever the cursor is.
+    *                When the cursor is moved by something else during playback, nature.onInterference decides
+    *                whether the move stops there or continues from there.
     */
-    static void Move(MotionNature& nature, int x, int y)
+    template <typename Nature>
+    static void Move(Nature& nature, int x, int y, MoveControl *control = nullptr)
     {
-        Dimension screenSize(nature.systemCalls->getScreenSize());
-        Point<int> mousePosition = nature.systemCalls->getMousePosition();
-
-        int xDest = std::max(0, std::min(screenSize.Width - 1, x));
-        int yDest = std::max(0, std::min(screenSize.Height - 1, y));
+        PlaybackStats *stats = nature.stats.get();
+        time_type moveStart = stats ? Deref(nature.systemCalls).currentTimeNanos() : 0;
+        auto layout = Deref(nature.systemCalls).getScreenLayout();
+        Point<int> mousePosition = GetMousePosition(nature);
+        // Whether mousePosition was just read, so planning the next movement doesn't have to ask again
+        bool mousePositionFresh = true;
+        bool firstMovement = true;
+
+        Point<int> dest = layout->clamp({x, y});
+        int xDest = dest.x;
+        int yDest = dest.y;
 
         Logger::Print(nature.info_printer, "Starting to move mouse to (%d, %d), current position: (%d, %d)", xDest, yDest, mousePosition.x, mousePosition.y);
 
 
-        MovementFactory movementFactory(nature, xDest, yDest);
+        BasicMovementFactory<Nature> movementFactory(nature, xDest, yDest, layout);
         auto movements = movementFactory.createMovements(mousePosition);
         auto overshoots = movements.size() - 1;
+        int movementIndex = 0;
+        if (control)
+        {
+            control->movements.store((int)movements.size(), std::memory_order_relaxed);
+        }
+        StepBuffers::Lease buffers(nature.stepBuffers);
+        MovementSteps &steps = buffers.get();
+        // Real-time settings only apply while this move plays back
+        RealtimeScope realtime(nature.realtime, steps, stats ? &stats->realtime : nullptr, nature.info_printer);
+        // Motion from before the move doesn't count as interference
+        ForeignMotionWatch<Nature> watch(nature);
         while (mousePosition.x != xDest || mousePosition.y != yDest)
         {
+            if (control && control->isCancelled())
+            {
+                Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) cancelled", xDest, yDest);
+                return;
+            }
             if (movements.empty())
             {
                 // This shouldn't usually happen, but it's possible that somehow we won't end up on the target,
                 // Then just re-attempt from mouse new position. (There are known JDK bugs, that can cause sending the cursor
                 // to wrong pixel)
-                mousePosition = nature.systemCalls->getMousePosition();
+                mousePosition = GetMousePosition(nature);
+                mousePositionFresh = true;
                 Logger::Print(nature.debug_printer, "Re-populating movement array. Did not end up on target pixel.");
                 movements = movementFactory.createMovements(mousePosition);
+                if (control)
+                {
+                    control->movements.store(movementIndex + (int)movements.size(), std::memory_order_relaxed);
+                }
             }
 
             Movement movement = movements.front();
             movements.pop_front();
             if (!movements.empty())
             {
-                Logger::Print(nature.debug_printer, "Using overshoots (%d out of %d), aiming at (%d, %d)", overshoots - movements.size() + 1, overshoots, movement.destX, movement.destY);
+                Logger::Print(nature.debug_printer, "Using overshoots (%d out of %d), aiming at (%d, %d)", (int)(overshoots - movements.size() + 1), (int)overshoots, movement.destX, movement.destY);
             }
 
-            double distance = movement.distance;
-            time_type mouseMovementMs = movement.time;
-            const Flow *flow = movement.flow;
-            double xDistance = movement.xDistance;
-            double yDistance = movement.yDistance;
-            Logger::Print(nature.info_printer, "Movement arc length computed to %f and time predicted to %d ms", distance, mouseMovementMs);
-
-            /* Number of steps is calculated from the movement time and limited by minimal amount of steps
-            (should have at least MIN_STEPS) and distance (shouldn't have more steps than pixels travelled) */
-            auto steps = (int)std::ceil(std::min(distance, std::max((double)mouseMovementMs / nature.timeToStepsDivider, (double)nature.minSteps)));
-
-            auto startTime = nature.systemCalls->currentTimeMillis();
-            time_type stepTime = mouseMovementMs / steps;
-
-            mousePosition = nature.systemCalls->getMousePosition();
-            double simulatedMouseX = mousePosition.x;
-            double simulatedMouseY = mousePosition.y;
-
-            double deviationMultiplierX = (nature.random() - 0.5) * 2;
-            double deviationMultiplierY = (nature.random() - 0.5) * 2;
+            Logger::Print(nature.info_printer, "Movement arc length computed to %f and time predicted to %lld ms", movement.distance, (long long)movement.time);
 
-            double completedXDistance = 0;
-            double completedYDistance = 0;
-            double noiseX = 0;
-            double noiseY = 0;
-
-            for (decltype(steps) i = 0; i < steps; i++)
+            if (!mousePositionFresh)
+            {
+                // The cursor may have been moved during the reaction time
+                mousePosition = GetMousePosition(nature);
+            }
+            mousePositionFresh = false;
+            time_type planStart = stats ? Deref(nature.systemCalls).currentTimeNanos() : 0;
+            StepKernel::Plan(nature, movement, mousePosition, *layout, steps);
+            if (stats)
+            {
+                stats->planningTime.add(Deref(nature.systemCalls).currentTimeNanos() - planStart);
+            }
+            if (control)
             {
-                // All steps take equal amount of time. This is a value from 0...1 describing how far along the process is.
-                double timeCompletion = i / (double)steps;
+                control->step.store(0, std::memory_order_relaxed);
+                control->steps.store(steps.steps, std::memory_order_relaxed);
+                control->movement.store(++movementIndex, std::memory_order_relaxed);
+            }
 
-                double effectFadeStep = std::max(i - (steps - nature.effectFadeSteps) + 1, 0);
-                // value from 0 to 1, when effectFadeSteps remaining steps, starts to decrease to 0 linearly
-                // This is here so noise and deviation wouldn't add offset to mouse final position, when we need accuracy.
-                double effectFadeMultiplier = (nature.effectFadeSteps - effectFadeStep) / nature.effectFadeSteps;
+            if (stats && firstMovement)
+            {
+                stats->timeToFirstStep.add(Deref(nature.systemCalls).currentTimeNanos() - moveStart);
+            }
+            firstMovement = false;
 
-                double xStepSize = flow->getStepSize(xDistance, steps, timeCompletion);
-                double yStepSize = flow->getStepSize(yDistance, steps, timeCompletion);
+            auto playback = PlaySteps(nature, movement, steps, control);
+            if (playback == Playback::Cancelled)
+            {
+                return;
+            }
+            if (playback == Playback::Interfered)
+            {
+                mousePosition = GetMousePosition(nature);
+                if (!ReactToInterference(nature, movementFactory, mousePosition, dest, movements, control, movementIndex))
+                {
+                    return;
+                }
+                mousePositionFresh = true;
+                continue;
+            }
+            mousePosition = SettleAt(nature, movement);
 
-                completedXDistance += xStepSize;
-                completedYDistance += yStepSize;
-                double completedDistance = std::hypot(completedXDistance, completedYDistance);
-                double completion = std::min(1.0, completedDistance / distance);
-                Logger::Print(nature.debug_printer, "Step: x: %f y: %f tc: %f c: %f", xStepSize, yStepSize, timeCompletion, completion);
+            if (mousePosition.x != xDest || mousePosition.y != yDest)
+            {
+                // We are dealing with overshoot, let's sleep a bit to simulate human reaction time.
+                ReactionSleep(nature, nature.reactionTimeBaseMs + (time_type)(nature.random() * (double)nature.reactionTimeVariationMs), control);
+            }
+            Logger::Print(nature.info_printer, "Steps completed, mouse at %d, %d", mousePosition.x, mousePosition.y);
+        }
+        Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) completed", xDest, yDest);
+    }
 
-                auto noise = nature.getNoise(nature.random, xStepSize, yStepSize);
-                auto deviation = nature.getDeviation(distance, completion);
+    /**
+     * Emits the planned steps of a movement at their deadlines.
+     * Unless the nature ignores interference, SystemCalls::takeForeignMotion is asked after every step,
+     * and playback stops at the first step that was disturbed. The steps played until then go into the stats.
+     */
+    template <typename Nature>
+    static Playback PlaySteps(Nature& nature, const Movement& movement, const MovementSteps& steps, MoveControl *control = nullptr)
+    {
+        PlaybackStats *stats = nature.stats.get();
+        auto now = [&nature]() { return Deref(nature.systemCalls).currentTimeNanos(); };
+        // Scheduled in nanoseconds, so the steps add up to the movement time even when a step is a fraction of a millisecond off
+        StepPlayback playback{now(), 0, 0};
+        while (playback.next < steps.steps)
+        {
+            auto played = PlayStep(nature, movement, steps, control, playback, now);
+            if (played == Playback::Cancelled)
+            {
+                return played;
+            }
+            if (played == Playback::Interfered)
+            {
+                FinishSteps(nature, steps, playback, now);
+                return played;
+            }
 
-                noiseX += noise.y;
-                noiseY += noise.y;
-                simulatedMouseX += xStepSize;
-                simulatedMouseY += yStepSize;
+            // Deadlines are absolute, a late wake-up shortens the next wait instead of delaying every step after it
+            time_type endTime = playback.startTime + (time_type)steps.startOf(playback.next);
+            if (stats && now() < endTime)
+            {
+                Deref(nature.systemCalls).sleepUntilNanos(endTime);
+                stats->oversleep.add(now() - endTime);
+            }
+            else
+            {
+                Deref(nature.systemCalls).sleepUntilNanos(endTime);
+            }
+        }
+        FinishSteps(nature, steps, playback, now);
+        return Playback::Completed;
+    }
 
-                Logger::Print(nature.debug_printer, "EffectFadeMultiplier: %f", effectFadeMultiplier);
-                Logger::Print(nature.debug_printer, "SimulatedMouse: [%f, %f]", simulatedMouseX, simulatedMouseY);
+    /**
+     * How far the steps of a movement have been played, see PlayStep
+     */
+    struct StepPlayback
+    {
+        time_type startTime;
+        // The step to play next, those before it were played or dropped
+        int next;
+        uint64_t droppedSteps;
+    };
 
-                time_type endTime = startTime + stepTime * (i + 1);
-                auto mousePosX = roundTowards(
-                    simulatedMouseX +
-                        deviation.x * deviationMultiplierX * effectFadeMultiplier +
-                        noiseX * effectFadeMultiplier,
-                    movement.destX);
+    /**
+     * Plays the next step of a movement. Every way of playing moves back shares this, they only differ in how
+     * they wait for the deadline of the following step, playback.startTime + steps.startOf(playback.next).
+     * When the nature drops late steps the ones whose time has passed are skipped. The step is set, published
+     * to the control and the observer, then foreign motion is asked for unless the nature ignores interference.
+     *
+     * @param now returns the current time on the clock of playback.startTime, only called when it is needed
+     * @return Completed when the step was played, Cancelled without playing it when the control was cancelled,
+     *         Interfered when it was played and the cursor was moved by something else
+     */
+    template <typename Nature, typename Clock>
+    static Playback PlayStep(Nature& nature, const Movement& movement, const MovementSteps& steps, MoveControl *control, StepPlayback& playback, Clock now)
+    {
+        auto i = playback.next;
+        if (control && control->isCancelled())
+        {
+            Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) cancelled at step %d of %d", movement.destX, movement.destY, i, steps.steps);
+            return Playback::Cancelled;
+        }
+        PlaybackStats *stats = nature.stats.get();
+        time_type current = (stats || nature.dropLateSteps) ? now() : 0;
+        if (nature.dropLateSteps && steps.stepNanos > 0)
+        {
+            // Play the step planned for the current time, the ones before it are stale
+            auto due = (decltype(i))((current - playback.startTime) / steps.stepNanos);
+            due = std::min(due, steps.steps - 1);
+            if (due > i)
+            {
+                playback.droppedSteps += due - i;
+                i = due;
+            }
+        }
+        if (stats)
+        {
+            stats->stepLateness.add(current - (playback.startTime + (time_type)steps.startOf(i)));
+        }
+        SetMousePosition(nature, steps.x[i], steps.y[i]);
+        playback.next = i + 1;
+        if (control)
+        {
+            control->step.store(i + 1, std::memory_order_relaxed);
+        }
 
-                auto mousePosY = roundTowards(
-                    simulatedMouseY +
-                        deviation.y * deviationMultiplierY * effectFadeMultiplier +
-                        noiseY * effectFadeMultiplier,
-                    movement.destY);
+        // Allow other action to take place or just observe, we'll later compensate by sleeping less.
+        if (nature.observer)
+        {
+            nature.observer(steps.x[i], steps.y[i]);
+        }
 
-                mousePosX = std::max(0, std::min(screenSize.Width - 1, mousePosX));
-                mousePosY = std::max(0, std::min(screenSize.Height - 1, mousePosY));
+        if (nature.onInterference != InterferencePolicy::Ignore && Deref(nature.systemCalls).takeForeignMotion())
+        {
+            Logger::Print(nature.info_printer, "Mouse moved by something else at step %d of %d of the movement to (%d, %d)", i + 1, steps.steps, movement.destX, movement.destY);
+            if (stats)
+            {
+                stats->interferences++;
+            }
+            return Playback::Interfered;
+        }
+        return Playback::Completed;
+    }
 
-                nature.systemCalls->setMousePosition(mousePosX, mousePosY);
+    /**
+     * Logs the dropped steps and adds the steps played so far to the stats, once the last step was played
+     * or playback stopped for interference
+     * @param now returns the current time on the clock of playback.startTime, only called when it is needed
+     */
+    template <typename Nature, typename Clock>
+    static void FinishSteps(Nature& nature, const MovementSteps& steps, const StepPlayback& playback, Clock now)
+    {
+        if (playback.droppedSteps > 0)
+        {
+            Logger::Print(nature.debug_printer, "Dropped %d late steps out of %d", (int)playback.droppedSteps, playback.next);
+        }
+        if (PlaybackStats *stats = nature.stats.get())
+        {
+            stats->emittedSteps += playback.next - playback.droppedSteps;
+            stats->droppedSteps += playback.droppedSteps;
+            stats->plannedNanos += (time_type)steps.startOf(playback.next);
+            stats->actualNanos += now() - playback.startTime;
+        }
+    }
 
-                // Allow other action to take place or just observe, we'll later compensate by sleeping less.
-                if (nature.observer)
-                {
-                    nature.observer(mousePosX, mousePosY);
-                }
+    /**
+     * Reacts to a movement that was interfered with as the nature says, after the cursor was read again
+     * @param movements receives the movements from where the cursor is now, unless the move is aborted
+     * @return false when the move is aborted
+     */
+    template <typename Nature>
+    static bool ReactToInterference(Nature& nature, BasicMovementFactory<Nature>& movementFactory, Point<int> mousePosition, Point<int> dest,
+            MovementList& movements, MoveControl *control, int movementIndex)
+    {
+        if (nature.onInterference == InterferencePolicy::Abort)
+        {
+            Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) aborted, mouse was moved to (%d, %d)", dest.x, dest.y, mousePosition.x, mousePosition.y);
+            return false;
+        }
+        Logger::Print(nature.info_printer, "Mouse was moved to (%d, %d), re-planning movement to (%d, %d)", mousePosition.x, mousePosition.y, dest.x, dest.y);
+        movements = movementFactory.createMovements(mousePosition);
+        if (control)
+        {
+            control->movements.store(movementIndex + (int)movements.size(), std::memory_order_relaxed);
+        }
+        return true;
+    }
 
-                time_type timeLeft = endTime - nature.systemCalls->currentTimeMillis();
-                nature.systemCalls->sleep(std::max(timeLeft, (time_type)0));
-            }
-            mousePosition = nature.systemCalls->getMousePosition();
+    /**
+     * Puts the cursor on the endpoint of the movement if it didn't end up there
+     * @return the mouse position after the movement
+     */
+    template <typename Nature>
+    static Point<int> SettleAt(Nature& nature, const Movement& movement)
+    {
+        auto mousePosition = GetMousePosition(nature);
 
-            if (mousePosition.x != movement.destX || mousePosition.y != movement.destY)
-            {
-                // It's possible that mouse is manually moved or for some other reason.
-                // Let's start next step from pre-calculated location to prevent errors from accumulating.
-                // But print warning as this is not expected behavior.
-                Logger::Print(nature.info_printer, "Mouse off from step endpoint (adjustment was done) x:(%d -> %d) y:(%d -> %d)",
-                        mousePosition.x, movement.destX, mousePosition.y, movement.destY);
-                nature.systemCalls->setMousePosition(movement.destX, movement.destY);
-                // Let's wait a bit before getting mouse info.
-                nature.systemCalls->sleep(SLEEP_AFTER_ADJUSTMENT_MS);
-                mousePosition = nature.systemCalls->getMousePosition();
-            }
+        if (mousePosition.x != movement.destX || mousePosition.y != movement.destY)
+        {
+            // It's possible that mouse is manually moved or for some other reason.
+            // Let's start next step from pre-calculated location to prevent errors from accumulating.
+            // But print warning as this is not expected behavior.
+            Logger::Print(nature.info_printer, "Mouse off from step endpoint (adjustment was done) x:(%d -> %d) y:(%d -> %d)",
+                    mousePosition.x, movement.destX, mousePosition.y, movement.destY);
+            SetMousePosition(nature, movement.destX, movement.destY);
+            // Let's wait a bit before getting mouse info.
+            Deref(nature.systemCalls).sleep(SLEEP_AFTER_ADJUSTMENT_MS);
+            mousePosition = GetMousePosition(nature);
+        }
+        return mousePosition;
+    }
 
-            if (mousePosition.x != xDest || mousePosition.y != yDest)
+    /**
+     * Sleeps in slices of CANCEL_CHECK_MS when the move can be cancelled, so cancelling doesn't wait out the reaction time
+     */
+    template <typename Nature>
+    static void ReactionSleep(Nature& nature, time_type ms, MoveControl *control)
+    {
+        if (!control)
+        {
+            Deref(nature.systemCalls).sleep(ms);
+            return;
+        }
+        auto deadline = Deref(nature.systemCalls).currentTimeNanos() + ms * NANOS_IN_MILLI;
+        while (!control->isCancelled())
+        {
+            auto now = Deref(nature.systemCalls).currentTimeNanos();
+            if (now >= deadline)
             {
-                // We are dealing with overshoot, let's sleep a bit to simulate human reaction time.
-                nature.systemCalls->sleep(nature.reactionTimeBaseMs + (time_type)(nature.random() * (double)nature.reactionTimeVariationMs));
+                return;
             }
-            Logger::Print(nature.info_printer, "Steps completed, mouse at %d, %d", mousePosition.x, mousePosition.y);
+            Deref(nature.systemCalls).sleepUntilNanos(std::min(deadline, now + CANCEL_CHECK_MS * NANOS_IN_MILLI));
         }
-        Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) completed", xDest, yDest);
     }
 
-private:
+    /**
+     * Reads the mouse position, timed into the stats when they are enabled
+     */
+    template <typename Nature>
+    static Point<int> GetMousePosition(Nature& nature)
+    {
+        if (!nature.stats)
+        {
+            return Deref(nature.systemCalls).getMousePosition();
+        }
+        auto start = Deref(nature.systemCalls).currentTimeNanos();
+        auto position = Deref(nature.systemCalls).getMousePosition();
+        nature.stats->getMousePositionTime.add(Deref(nature.systemCalls).currentTimeNanos() - start);
+        return position;
+    }
 
-    static int roundTowards(double value, int target)
+    /**
+     * Sets the mouse position, timed into the stats when they are enabled
+     */
+    template <typename Nature>
+    static void SetMousePosition(Nature& nature, int x, int y)
     {
-        if (target > value)
-            return (int)std::ceil(value);
-        else
-            return (int)std::floor(value);
+        if (!nature.stats)
+        {
+            Deref(nature.systemCalls).setMousePosition(x, y);
+            return;
+        }
+        auto start = Deref(nature.systemCalls).currentTimeNanos();
+        Deref(nature.systemCalls).setMousePosition(x, y);
+        nature.stats->setMousePositionTime.add(Deref(nature.systemCalls).currentTimeNanos() - start);
     }
 };
 
@@ -173,6 +469,10 @@ private:
 // Might change when/if have multiple movement methods like spiraldown/movedirect/movevia/
 // Then usage becomes:  NaturalMouseMotion::Move::To(nature, 200, 25);  NaturalMouseMotion::Move::Spiral(nature, 200, 25);
 // But no point having a NaturalMouseMotion::Move::To() for now; so provide NaturalMouseMotion::Move() 
-const auto& Move = MoveImp::Move;  // alias
+template <typename Nature>
+inline void Move(Nature& nature, int x, int y)
+{
+    MoveImp::Move(nature, x, y);
+}
 
 } // namespace NaturalMouseMotion
\ No newline at end of file
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Move.h"
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * Plays back moves on a worker thread of its own, one at a time in the order they were posted.
+ * Destroying the executor cancels the moves posted with a MoveControl, the one playing stops before its
+ * next step and the queued ones don't start, so a process doesn't wait for the whole queue on exit.
+ * Tasks posted without a control still run before the destructor returns.
+ */
+class PlaybackExecutor
+{
+public:
+	PlaybackExecutor() : worker([this]() { run(); })
+	{
+	}
+
+	~PlaybackExecutor()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+			if (running)
+			{
+				running->cancel();
+			}
+			for (auto &task : tasks)
+			{
+				if (task.control)
+				{
+					task.control->cancel();
+				}
+			}
+		}
+		wakeUp.notify_one();
+		worker.join();
+	}
+
+	PlaybackExecutor(const PlaybackExecutor &) = delete;
+	PlaybackExecutor &operator=(const PlaybackExecutor &) = delete;
+
+	/**
+	 * @param task run on the worker thread after the tasks posted before it
+	 * @param control cancelled when the executor is destroyed before the task has finished, may be nullptr
+	 */
+	void post(std::function<void()> task, std::shared_ptr<MoveControl> control = nullptr)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(Task{std::move(task), std::move(control)});
+		}
+		wakeUp.notify_one();
+	}
+
+	/**
+	 * @return the executor MoveAsync uses when none is given, started on first use
+	 */
+	static PlaybackExecutor &Default()
+	{
+		static PlaybackExecutor executor;
+		return executor;
+	}
+
+private:
+	struct Task
+	{
+		std::function<void()> run;
+		std::shared_ptr<MoveControl> control;
+	};
+
+	std::mutex mutex{};
+	std::condition_variable wakeUp{};
+	std::deque<Task> tasks{};
+	// The control of the task being run
+	std::shared_ptr<MoveControl> running{};
+	bool stopping{false};
+	// Last, so everything the worker uses is constructed before it starts
+	std::thread worker;
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			wakeUp.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (tasks.empty())
+			{
+				return;
+			}
+			auto task = std::move(tasks.front());
+			tasks.pop_front();
+			running = task.control;
+			lock.unlock();
+			task.run();
+			lock.lock();
+			running = nullptr;
+		}
+	}
+};
+
+/**
+ * Refers to a move started with MoveAsync. Copies refer to the same move.
+ */
+class MoveHandle
+{
+public:
+	MoveHandle() = default;
+
+	MoveHandle(std::shared_ptr<MoveControl> control, std::shared_future<void> result) : control(std::move(control)), result(std::move(result))
+	{
+	}
+
+	/**
+	 * Blocks until the move has finished, was cancelled or failed. Rethrows what the move threw.
+	 * Returns at once for a handle that refers to no move.
+	 */
+	void wait() const
+	{
+		if (result.valid())
+		{
+			result.get();
+		}
+	}
+
+	/**
+	 * @return true when the move finished within the time, or the handle refers to no move. A failure is rethrown by wait
+	 */
+	bool waitFor(time_type ms) const
+	{
+		return !result.valid() || result.wait_for(std::chrono::milliseconds(ms)) == std::future_status::ready;
+	}
+
+	bool done() const
+	{
+		return waitFor(0);
+	}
+
+	/**
+	 * Asks the move to stop, it does so before its next step. A move still queued doesn't start.
+	 * Does nothing for a handle that refers to no move, see valid().
+	 */
+	void cancel()
+	{
+		if (control)
+		{
+			control->cancel();
+		}
+	}
+
+	bool isCancelled() const
+	{
+		return control && control->isCancelled();
+	}
+
+	/**
+	 * @return all zero for a handle that refers to no move
+	 */
+	MoveProgress progress() const
+	{
+		return control ? control->progress() : MoveProgress{0, 0, 0, 0};
+	}
+
+	bool valid() const
+	{
+		return control != nullptr;
+	}
+
+private:
+	std::shared_ptr<MoveControl> control{};
+	std::shared_future<void> result{};
+};
+
+/**
+ * Move cursor smoothly to the destination coordinates on the executor, without blocking the caller.
+ * The nature is used by reference from the executor thread, it must outlive the move and not be used elsewhere until it is done.
+ *
+ * @param executor plays back the move after the ones posted before it
+ * @param nature the nature that defines how mouse is moved
+ * @param x the x-coordinate of destination
+ * @param y the y-coordinate of destination
+ * @return handle to wait for, observe or cancel the move
+ */
+template <typename Nature>
+MoveHandle MoveAsync(PlaybackExecutor &executor, Nature &nature, int x, int y)
+{
+	auto control = std::make_shared<MoveControl>();
+	auto promise = std::make_shared<std::promise<void>>();
+	MoveHandle handle(control, promise->get_future().share());
+	executor.post([&nature, x, y, control, promise]() {
+		try
+		{
+			if (!control->isCancelled())
+			{
+				MoveImp::Move(nature, x, y, control.get());
+			}
+			promise->set_value();
+		}
+		catch (...)
+		{
+			promise->set_exception(std::current_exception());
+		}
+	}, control);
+	return handle;
+}
+
+/**
+ * MoveAsync on PlaybackExecutor::Default()
+ */
+template <typename Nature>
+MoveHandle MoveAsync(Nature &nature, int x, int y)
+{
+	return MoveAsync(PlaybackExecutor::Default(), nature, x, y);
+}
+
+} // namespace NaturalMouseMotion
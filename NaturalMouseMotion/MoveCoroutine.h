@@ -0,0 +1,394 @@
+#pragma once
+
+/**
+ * Coroutine version of Move, for driving many motions from a single thread. Needs C++20 coroutines,
+ * when building as C++11 this header is empty and only the blocking Move is available.
+ */
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#if __has_include(<coroutine>)
+#define NATURAL_MOUSE_MOTION_COROUTINES 1
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "Move.h"
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * A motion played as a coroutine. It starts suspended, run it with TimerExecutor::spawn or co_await it
+ * from another MoveTask, so moves can be chained into a sequence. The task owns the coroutine and must
+ * outlive its execution.
+ */
+class [[nodiscard]] MoveTask
+{
+public:
+	struct promise_type
+	{
+		std::coroutine_handle<> continuation{};
+		std::exception_ptr failure{};
+
+		MoveTask get_return_object()
+		{
+			return MoveTask(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		std::suspend_always initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		/**
+		 * Continues the awaiting task, if there is one
+		 */
+		struct FinalAwaiter
+		{
+			bool await_ready() noexcept
+			{
+				return false;
+			}
+
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+			{
+				auto continuation = handle.promise().continuation;
+				return continuation ? continuation : std::noop_coroutine();
+			}
+
+			void await_resume() noexcept
+			{
+			}
+		};
+
+		FinalAwaiter final_suspend() noexcept
+		{
+			return {};
+		}
+
+		void return_void()
+		{
+		}
+
+		void unhandled_exception()
+		{
+			failure = std::current_exception();
+		}
+	};
+
+	MoveTask(MoveTask &&other) noexcept : handle(std::exchange(other.handle, nullptr))
+	{
+	}
+
+	MoveTask &operator=(MoveTask &&other) noexcept
+	{
+		if (this != &other)
+		{
+			destroy();
+			handle = std::exchange(other.handle, nullptr);
+		}
+		return *this;
+	}
+
+	MoveTask(const MoveTask &) = delete;
+	MoveTask &operator=(const MoveTask &) = delete;
+
+	~MoveTask()
+	{
+		destroy();
+	}
+
+	bool done() const
+	{
+		return handle && handle.done();
+	}
+
+	/**
+	 * Rethrows what the motion threw, once it is done
+	 */
+	void get() const
+	{
+		if (handle && handle.done() && handle.promise().failure)
+		{
+			std::rethrow_exception(handle.promise().failure);
+		}
+	}
+
+	/**
+	 * Awaiting a task starts it and resumes the awaiting coroutine once it is done
+	 */
+	bool await_ready() const noexcept
+	{
+		return !handle || handle.done();
+	}
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		handle.promise().continuation = awaiting;
+		return handle;
+	}
+
+	void await_resume() const
+	{
+		get();
+	}
+
+private:
+	friend class TimerExecutor;
+
+	std::coroutine_handle<promise_type> handle;
+
+	explicit MoveTask(std::coroutine_handle<promise_type> handle) : handle(handle)
+	{
+	}
+
+	void destroy()
+	{
+		if (handle)
+		{
+			handle.destroy();
+			handle = nullptr;
+		}
+	}
+};
+
+/**
+ * Single-threaded executor resuming coroutines at their deadlines, in deadline order.
+ * Coroutines waiting for the same deadline are resumed in the order they started waiting.
+ */
+class TimerExecutor
+{
+public:
+	/**
+	 * @param clock tells the time and sleeps until the next deadline, must outlive the executor
+	 */
+	explicit TimerExecutor(SystemCalls &clock) : clock(clock)
+	{
+	}
+
+	TimerExecutor(const TimerExecutor &) = delete;
+	TimerExecutor &operator=(const TimerExecutor &) = delete;
+
+	time_type now() const
+	{
+		return clock.currentTimeNanos();
+	}
+
+	/**
+	 * Starts the task on the next run
+	 */
+	void spawn(MoveTask &task)
+	{
+		if (task.handle && !task.handle.done())
+		{
+			schedule(now(), task.handle);
+		}
+	}
+
+	struct DeadlineAwaiter
+	{
+		TimerExecutor &executor;
+		time_type deadline;
+
+		bool await_ready() const
+		{
+			return executor.now() >= deadline;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			executor.schedule(deadline, handle);
+		}
+
+		void await_resume() const noexcept
+		{
+		}
+	};
+
+	/**
+	 * @return awaitable resuming the coroutine on the executor once the deadline has passed
+	 */
+	DeadlineAwaiter sleepUntil(time_type deadlineNanos)
+	{
+		return {*this, deadlineNanos};
+	}
+
+	DeadlineAwaiter sleepFor(time_type ms)
+	{
+		return {*this, now() + ms * NANOS_IN_MILLI};
+	}
+
+	/**
+	 * Resumes coroutines until none is waiting, sleeping on the clock until each deadline
+	 */
+	void run()
+	{
+		while (!timers.empty())
+		{
+			auto timer = timers.top();
+			if (clock.currentTimeNanos() < timer.deadline)
+			{
+				clock.sleepUntilNanos(timer.deadline);
+			}
+			timers.pop();
+			timer.handle.resume();
+		}
+	}
+
+	size_t waiting() const
+	{
+		return timers.size();
+	}
+
+private:
+	struct Timer
+	{
+		time_type deadline;
+		uint64_t sequence;
+		std::coroutine_handle<> handle;
+
+		bool operator>(const Timer &other) const
+		{
+			return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+		}
+	};
+
+	SystemCalls &clock;
+	std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers{};
+	uint64_t sequence{0};
+
+	void schedule(time_type deadline, std::coroutine_handle<> handle)
+	{
+		timers.push({deadline, sequence++, handle});
+	}
+};
+
+/**
+ * Move cursor smoothly to the destination coordinates from whereever the cursor currently is, like MoveImp::Move,
+ * but awaiting step deadlines on the executor instead of sleeping, so one thread drives many motions.
+ * Times are taken from the executor's clock, the cursor is set through the nature's SystemCalls.
+ * The nature's real-time settings aren't applied, the executor thread is shared by every motion.
+ *
+ * @param executor resumes the motion at its step deadlines
+ * @param nature the nature that defines how mouse is moved, must outlive the task
+ * @param x the x-coordinate of destination
+ * @param y the y-coordinate of destination
+ * @param control receives the progress and is checked for cancellation before every step, may be nullptr,
+ *                must outlive the task. Interference is reacted to as by MoveImp::Move.
+ */
+template <typename Nature>
+MoveTask MoveCoroutine(TimerExecutor &executor, Nature &nature, int x, int y, MoveControl *control = nullptr)
+{
+	auto layout = Deref(nature.systemCalls).getScreenLayout();
+	Point<int> mousePosition = MoveImp::GetMousePosition(nature);
+	// Whether mousePosition was just read, so planning the next movement doesn't have to ask again
+	bool mousePositionFresh = true;
+
+	Point<int> dest = layout->clamp({x, y});
+	int xDest = dest.x;
+	int yDest = dest.y;
+
+	Logger::Print(nature.info_printer, "Starting to move mouse to (%d, %d), current position: (%d, %d)", xDest, yDest, mousePosition.x, mousePosition.y);
+
+	BasicMovementFactory<Nature> movementFactory(nature, xDest, yDest, layout);
+	auto movements = movementFactory.createMovements(mousePosition);
+	int movementIndex = 0;
+	if (control)
+	{
+		control->movements.store((int)movements.size(), std::memory_order_relaxed);
+	}
+	// Each motion has buffers of its own, motions on the executor interleave
+	MovementSteps steps;
+	// Motion from before the move doesn't count as interference
+	MoveImp::ForeignMotionWatch<Nature> watch(nature);
+	auto now = [&executor]() { return executor.now(); };
+	while (mousePosition.x != xDest || mousePosition.y != yDest)
+	{
+		if (control && control->isCancelled())
+		{
+			Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) cancelled", xDest, yDest);
+			co_return;
+		}
+		if (movements.empty())
+		{
+			mousePosition = MoveImp::GetMousePosition(nature);
+			mousePositionFresh = true;
+			Logger::Print(nature.debug_printer, "Re-populating movement array. Did not end up on target pixel.");
+			movements = movementFactory.createMovements(mousePosition);
+			if (control)
+			{
+				control->movements.store(movementIndex + (int)movements.size(), std::memory_order_relaxed);
+			}
+		}
+
+		Movement movement = movements.front();
+		movements.pop_front();
+		Logger::Print(nature.info_printer, "Movement arc length computed to %f and time predicted to %lld ms", movement.distance, (long long)movement.time);
+
+		if (!mousePositionFresh)
+		{
+			mousePosition = MoveImp::GetMousePosition(nature);
+		}
+		mousePositionFresh = false;
+		StepKernel::Plan(nature, movement, mousePosition, *layout, steps);
+		if (control)
+		{
+			control->step.store(0, std::memory_order_relaxed);
+			control->steps.store(steps.steps, std::memory_order_relaxed);
+			control->movement.store(++movementIndex, std::memory_order_relaxed);
+		}
+
+		MoveImp::StepPlayback playback{executor.now(), 0, 0};
+		auto played = MoveImp::Playback::Completed;
+		while (playback.next < steps.steps)
+		{
+			played = MoveImp::PlayStep(nature, movement, steps, control, playback, now);
+			if (played != MoveImp::Playback::Completed)
+			{
+				break;
+			}
+			co_await executor.sleepUntil(playback.startTime + (time_type)steps.startOf(playback.next));
+		}
+		if (played == MoveImp::Playback::Cancelled)
+		{
+			co_return;
+		}
+		MoveImp::FinishSteps(nature, steps, playback, now);
+		if (played == MoveImp::Playback::Interfered)
+		{
+			mousePosition = MoveImp::GetMousePosition(nature);
+			if (!MoveImp::ReactToInterference(nature, movementFactory, mousePosition, dest, movements, control, movementIndex))
+			{
+				co_return;
+			}
+			mousePositionFresh = true;
+			continue;
+		}
+
+		mousePosition = MoveImp::GetMousePosition(nature);
+		if (mousePosition.x != movement.destX || mousePosition.y != movement.destY)
+		{
+			Logger::Print(nature.info_printer, "Mouse off from step endpoint (adjustment was done) x:(%d -> %d) y:(%d -> %d)",
+				mousePosition.x, movement.destX, mousePosition.y, movement.destY);
+			MoveImp::SetMousePosition(nature, movement.destX, movement.destY);
+			co_await executor.sleepFor(MoveImp::SLEEP_AFTER_ADJUSTMENT_MS);
+			mousePosition = MoveImp::GetMousePosition(nature);
+		}
+
+		if (mousePosition.x != xDest || mousePosition.y != yDest)
+		{
+			// We are dealing with overshoot, let's wait a bit to simulate human reaction time.
+			co_await executor.sleepFor(nature.reactionTimeBaseMs + (time_type)(nature.random() * (double)nature.reactionTimeVariationMs));
+		}
+	}
+	Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) completed", xDest, yDest);
+}
+
+} // namespace NaturalMouseMotion
+
+#endif
+#endif
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Move.h"
+#include "SpscRing.h"
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * A movement and its steps, planned ahead of playback
+ */
+struct PlannedMovement
+{
+	enum class Kind
+	{
+		Movement,
+		/**
+		 * Last slot of a request, carries the failure if planning threw
+		 */
+		End
+	};
+
+	Kind kind{Kind::End};
+	Movement movement{};
+	MovementSteps steps{};
+	/**
+	 * Reaction time to wait after a movement that doesn't reach its target
+	 */
+	time_type reactionTimeMs{0};
+	bool reachesTarget{false};
+	Point<int> target{0, 0};
+	std::exception_ptr failure{};
+};
+
+/**
+ * Moves the cursor like MoveImp::Move, but plans on a thread of its own while the calling thread plays back.
+ * Planned movements are handed to the player through a lock-free ring, so the next movement, or the next target,
+ * is planned while the current one plays or during the reaction time, and planning never delays the cursor.
+ * The planner uses the random, flow, noise, deviation and overshoot providers of the nature, the player its
+ * SystemCalls, observer and stats. They must not be used elsewhere while a move plays.
+ * planningTime isn't recorded in the stats, as planning is no longer part of playback.
+ * Movements are planned ahead, so unless the nature ignores interference a disturbed move always stops
+ * where the cursor was moved to, as with InterferencePolicy::Abort.
+ *
+ * @tparam Nature the nature type, as for BasicMovementFactory
+ * @tparam Capacity movements planned ahead at most, a power of two
+ */
+template <typename Nature, size_t Capacity = 4>
+class BasicMovePipeline
+{
+public:
+	explicit BasicMovePipeline(Nature &nature) : nature(nature), planner([this]() { run(); })
+	{
+	}
+
+	~BasicMovePipeline()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		requested.notify_one();
+		planner.join();
+	}
+
+	BasicMovePipeline(const BasicMovePipeline &) = delete;
+	BasicMovePipeline &operator=(const BasicMovePipeline &) = delete;
+
+	/**
+	 * Move cursor smoothly to the destination coordinates from whereever the cursor currently is.
+	 * Blocking call
+	 */
+	void Move(int x, int y)
+	{
+		playerTargets.clear();
+		playerTargets.push_back({x, y});
+		Move(playerTargets);
+	}
+
+	/**
+	 * Moves through the targets in order, each one is planned while the one before it plays.
+	 * Blocking call, rethrows what planning or playback threw.
+	 */
+	void Move(const std::vector<Point<int>> &targets)
+	{
+		if (&targets != &playerTargets)
+		{
+			playerTargets.assign(targets.begin(), targets.end());
+		}
+		if (playerTargets.empty())
+		{
+			return;
+		}
+		PlaybackStats *stats = nature.stats.get();
+		time_type moveStart = stats ? Deref(nature.systemCalls).currentTimeNanos() : 0;
+		auto layout = Deref(nature.systemCalls).getScreenLayout();
+		Point<int> mousePosition = MoveImp::GetMousePosition(nature);
+		// Applied before the planner starts writing into the slots it locks
+		RingBuffers buffers{ring};
+		BasicRealtimeScope<RingBuffers> realtime(nature.realtime, buffers, stats ? &stats->realtime : nullptr, nature.info_printer);
+		// Motion from before the move doesn't count as interference
+		MoveImp::ForeignMotionWatch<Nature> watch(nature);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			requestTargets.clear();
+			for (auto &target : playerTargets)
+			{
+				requestTargets.push_back(layout->clamp(target));
+			}
+			requestStart = mousePosition;
+			requestLayout = layout;
+			aborting.store(false);
+			pending = true;
+		}
+		requested.notify_one();
+
+		std::exception_ptr failure;
+		try
+		{
+			failure = play(stats, moveStart);
+		}
+		catch (...)
+		{
+			// The planner may be waiting for a free slot, take what it planned until it has ended the request
+			aborting.store(true);
+			drain();
+			throw;
+		}
+		if (failure)
+		{
+			std::rethrow_exception(failure);
+		}
+	}
+
+private:
+	/**
+	 * The step buffers of every slot, for BasicRealtimeScope
+	 */
+	struct RingBuffers
+	{
+		SpscRing<PlannedMovement, Capacity> &ring;
+
+		template <typename F>
+		void forEachSteps(F f)
+		{
+			ring.forEachSlot([&f](PlannedMovement &slot) { f(slot.steps); });
+		}
+	};
+
+	Nature &nature;
+	SpscRing<PlannedMovement, Capacity> ring{};
+	std::atomic<bool> aborting{false};
+	// Reused by the player, so queuing a move doesn't allocate once it has grown large enough
+	std::vector<Point<int>> playerTargets{};
+
+	std::mutex mutex{};
+	std::condition_variable requested{};
+	std::vector<Point<int>> requestTargets{};
+	Point<int> requestStart{0, 0};
+	std::shared_ptr<const ScreenLayout> requestLayout{};
+	bool pending{false};
+	bool stopping{false};
+
+	// Only used by the planner thread
+	std::vector<Point<int>> plannerTargets{};
+	// Last, so everything the planner uses is constructed before it starts
+	std::thread planner;
+
+	/**
+	 * Player side, emits the planned movements until the end of the request
+	 * @return the failure the planner ended the request with
+	 */
+	std::exception_ptr play(PlaybackStats *stats, time_type moveStart)
+	{
+		for (bool firstMovement = true;; firstMovement = false)
+		{
+			auto slot = takeSlot();
+			if (slot->kind == PlannedMovement::Kind::End)
+			{
+				auto failure = slot->failure;
+				slot->failure = nullptr;
+				ring.release();
+				return failure;
+			}
+			if (stats && firstMovement)
+			{
+				stats->timeToFirstStep.add(Deref(nature.systemCalls).currentTimeNanos() - moveStart);
+			}
+			if (MoveImp::PlaySteps(nature, slot->movement, slot->steps) == MoveImp::Playback::Interfered)
+			{
+				// What is planned ahead starts where this movement was aimed at, so the move stops here
+				Logger::Print(nature.info_printer, "Mouse moved by something else, dropping the movements planned ahead");
+				ring.release();
+				aborting.store(true);
+				drain();
+				return nullptr;
+			}
+			auto mousePosition = MoveImp::SettleAt(nature, slot->movement);
+			auto reactionTimeMs = slot->reactionTimeMs;
+			auto reachesTarget = slot->reachesTarget;
+			auto target = slot->target;
+			// Given back before the reaction time, so the planner can use it while we wait
+			ring.release();
+
+			if (!reachesTarget)
+			{
+				// We are dealing with overshoot, let's sleep a bit to simulate human reaction time.
+				MoveImp::ReactionSleep(nature, reactionTimeMs, nullptr);
+			}
+			else if (mousePosition.x != target.x || mousePosition.y != target.y)
+			{
+				// The following target was planned from this one, so it can't be re-attempted like Move does
+				Logger::Print(nature.info_printer, "Did not end up on target pixel, mouse at (%d, %d) instead of (%d, %d)", mousePosition.x, mousePosition.y, target.x, target.y);
+			}
+			else
+			{
+				Logger::Print(nature.info_printer, "Mouse movement to (%d, %d) completed", target.x, target.y);
+			}
+		}
+	}
+
+	void drain()
+	{
+		for (;;)
+		{
+			auto slot = takeSlot();
+			auto end = slot->kind == PlannedMovement::Kind::End;
+			slot->failure = nullptr;
+			ring.release();
+			if (end)
+			{
+				return;
+			}
+		}
+	}
+
+	/**
+	 * Planning a movement takes microseconds, so the player only yields while waiting for one
+	 */
+	PlannedMovement *takeSlot()
+	{
+		PlannedMovement *slot;
+		while ((slot = ring.front()) == nullptr)
+		{
+			std::this_thread::yield();
+		}
+		return slot;
+	}
+
+	/**
+	 * A full ring is a whole movement ahead of the player, so the planner can afford to sleep while waiting
+	 * @return nullptr when the player is aborting and abortable
+	 */
+	PlannedMovement *claimSlot(bool abortable)
+	{
+		PlannedMovement *slot;
+		while ((slot = ring.claim()) == nullptr)
+		{
+			if (abortable && aborting.load())
+			{
+				return nullptr;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return slot;
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			requested.wait(lock, [this]() { return stopping || pending; });
+			if (!pending)
+			{
+				return;
+			}
+			pending = false;
+			plannerTargets.swap(requestTargets);
+			auto start = requestStart;
+			auto layout = std::move(requestLayout);
+			lock.unlock();
+
+			std::exception_ptr failure;
+			try
+			{
+				plan(start, layout);
+			}
+			catch (...)
+			{
+				failure = std::current_exception();
+			}
+			auto end = claimSlot(false);
+			end->kind = PlannedMovement::Kind::End;
+			end->failure = failure;
+			ring.publish();
+
+			lock.lock();
+		}
+	}
+
+	/**
+	 * Planner side. Draws from the random stream in the same order as MoveImp::Move does,
+	 * assuming every movement ends where it was aimed at, which playback makes sure of.
+	 */
+	void plan(Point<int> from, const std::shared_ptr<const ScreenLayout> &layout)
+	{
+		for (auto &target : plannerTargets)
+		{
+			Logger::Print(nature.info_printer, "Starting to move mouse to (%d, %d), current position: (%d, %d)", target.x, target.y, from.x, from.y);
+			BasicMovementFactory<Nature> movementFactory(nature, target.x, target.y, layout);
+			auto movements = movementFactory.createMovements(from);
+			while (!movements.empty() && (from.x != target.x || from.y != target.y))
+			{
+				Movement movement = movements.front();
+				movements.pop_front();
+				Logger::Print(nature.info_printer, "Movement arc length computed to %f and time predicted to %lld ms", movement.distance, (long long)movement.time);
+
+				auto slot = claimSlot(true);
+				if (!slot)
+				{
+					return;
+				}
+				StepKernel::Plan(nature, movement, from, *layout, slot->steps);
+				from = {movement.destX, movement.destY};
+				slot->kind = PlannedMovement::Kind::Movement;
+				slot->movement = movement;
+				slot->target = target;
+				slot->reactionTimeMs = 0;
+				slot->reachesTarget = from.x == target.x && from.y == target.y;
+				if (!slot->reachesTarget)
+				{
+					slot->reactionTimeMs = nature.reactionTimeBaseMs + (time_type)(nature.random() * (double)nature.reactionTimeVariationMs);
+				}
+				ring.publish();
+			}
+		}
+	}
+};
+
+using MovePipeline = BasicMovePipeline<MotionNature>;
+
+} // namespace NaturalMouseMotion
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <list>
+#include <memory>
+#include <vector>
+#include <utility>
 #include "MotionNature.h"
 
 namespace NaturalMouseMotion
@@ -16,22 +18,154 @@ struct Movement
 	time_type time;
 	const Flow *flow;
 
+	Movement() = default;
+
 	Movement(int destX, int destY, double distance, int xDistance, int yDistance, time_type time, const Flow *flow)
 		: destX(destX), destY(destY), distance(distance), xDistance(xDistance), yDistance(yDistance), time(time), flow(flow)
 	{
 	}
 };
 
-class MovementFactory
+/**
+ * Movements of a single move in the order they are made.
+ * Up to INLINE_CAPACITY movements are stored inline without allocating, which covers any reasonable
+ * amount of overshoots. Only when more are added the movements are moved to the heap.
+ */
+class MovementList
+{
+public:
+	static constexpr size_t INLINE_CAPACITY{16};
+
+	bool empty() const
+	{
+		return first == last;
+	}
+
+	size_t size() const
+	{
+		return last - first;
+	}
+
+	Movement &front()
+	{
+		return data()[first];
+	}
+
+	const Movement &front() const
+	{
+		return data()[first];
+	}
+
+	Movement &back()
+	{
+		return data()[last - 1];
+	}
+
+	const Movement &back() const
+	{
+		return data()[last - 1];
+	}
+
+	Movement *begin()
+	{
+		return data() + first;
+	}
+
+	Movement *end()
+	{
+		return data() + last;
+	}
+
+	const Movement *begin() const
+	{
+		return data() + first;
+	}
+
+	const Movement *end() const
+	{
+		return data() + last;
+	}
+
+	template <typename... Args>
+	void emplace_back(Args &&...args)
+	{
+		if (!spilled && last == INLINE_CAPACITY)
+		{
+			overflow.assign(inlineMovements, inlineMovements + last);
+			spilled = true;
+		}
+		if (spilled)
+		{
+			overflow.emplace_back(std::forward<Args>(args)...);
+		}
+		else
+		{
+			inlineMovements[last] = Movement(std::forward<Args>(args)...);
+		}
+		last++;
+	}
+
+	void pop_front()
+	{
+		first++;
+	}
+
+	void pop_back()
+	{
+		last--;
+		if (spilled)
+		{
+			overflow.pop_back();
+		}
+	}
+
+	void clear()
+	{
+		first = last = 0;
+		overflow.clear();
+		spilled = false;
+	}
+
+private:
+	Movement inlineMovements[INLINE_CAPACITY];
+	std::vector<Movement> overflow;
+	bool spilled{false};
+	size_t first{0};
+	size_t last{0};
+
+	Movement *data()
+	{
+		return spilled ? overflow.data() : inlineMovements;
+	}
+
+	const Movement *data() const
+	{
+		return spilled ? overflow.data() : inlineMovements;
+	}
+};
+
+/**
+ * Splits a move into the movements to the overshoot targets followed by the movement to the destination
+ */
+template <typename Nature>
+class BasicMovementFactory
 {
 public:
-	MovementFactory(MotionNature& nature, int xDest, int yDest) : xDest(xDest), yDest(yDest), nature(nature), screenSize(nature.systemCalls->getScreenSize())
+	BasicMovementFactory(Nature& nature, int xDest, int yDest) : BasicMovementFactory(nature, xDest, yDest, Deref(nature.systemCalls).getScreenLayout())
+	{
+	}
+
+	/**
+	 * @param layout the screen layout the caller already has, so it isn't asked from the SystemCalls again.
+	 * Overshoots are kept to the monitors.
+	 */
+	BasicMovementFactory(Nature& nature, int xDest, int yDest, std::shared_ptr<const ScreenLayout> layout) : xDest(xDest), yDest(yDest), nature(nature), layout(std::move(layout))
 	{
 	}
 
-	std::list<Movement> createMovements(Point<int> currentMousePosition)
+	MovementList createMovements(Point<int> currentMousePosition)
 	{
-		auto movements = std::list<Movement>();
+		MovementList movements;
 		auto lastMousePositionX = currentMousePosition.x;
 		auto lastMousePositionY = currentMousePosition.y;
 		auto xDistance = xDest - lastMousePositionX;
@@ -40,7 +174,7 @@ public:
 		auto flowTime = nature.getFlowWithTime(initialDistance);
 		auto flow = flowTime.first;
 		time_type mouseMovementMs = flowTime.second;
-		auto overshoots = nature.overshootManager->getOvershoots(flow, mouseMovementMs, initialDistance);
+		auto overshoots = Deref(nature.overshootManager).getOvershoots(flow, mouseMovementMs, initialDistance);
 		if (overshoots == 0)
 		{
 			Logger::Print(nature.debug_printer, "No overshoots for movement from (%d, %d) . (%d, %d)", currentMousePosition.x, currentMousePosition.y, xDest, yDest);
@@ -49,9 +183,10 @@ public:
 		}
 		for (auto i = overshoots; i > 0; i--)
 		{
-			auto overshoot = nature.overshootManager->getOvershootAmount(xDest - lastMousePositionX, yDest - lastMousePositionY, mouseMovementMs, i);
-			auto currentDestinationX = limitByScreenWidth(xDest + overshoot.x);
-			auto currentDestinationY = limitByScreenHeight(yDest + overshoot.y);
+			auto overshoot = Deref(nature.overshootManager).getOvershootAmount(xDest - lastMousePositionX, yDest - lastMousePositionY, mouseMovementMs, i);
+			auto currentDestination = layout->clamp({xDest + overshoot.x, yDest + overshoot.y});
+			auto currentDestinationX = currentDestination.x;
+			auto currentDestinationY = currentDestination.y;
 			xDistance = currentDestinationX - lastMousePositionX;
 			yDistance = currentDestinationY - lastMousePositionY;
 			auto distance = std::hypot(xDistance, yDistance);
@@ -61,7 +196,7 @@ public:
 				movements.emplace_back(currentDestinationX, currentDestinationY, distance, xDistance, yDistance, mouseMovementMs, flow);
 				lastMousePositionX = currentDestinationX;
 				lastMousePositionY = currentDestinationY;
-				mouseMovementMs = nature.overshootManager->deriveNextMouseMovementTimeMs(mouseMovementMs, i - 1);
+				mouseMovementMs = Deref(nature.overshootManager).deriveNextMouseMovementTimeMs(mouseMovementMs, i - 1);
 			}
 		}
 
@@ -74,47 +209,30 @@ public:
 		}
 		*/
 
-		for (auto rit = movements.rbegin(); rit != movements.rend();)
+		while (!movements.empty() && movements.back().destX == xDest && movements.back().destY == yDest)
 		{
-			if (rit->destX == xDest && rit->destY == yDest)
-			{
-				lastMousePositionX = rit->destX - rit->xDistance;
-				lastMousePositionY = rit->destY - rit->yDistance;
-				Logger::Print(nature.debug_printer, "Pruning 0-overshoot movement (Movement to target) from the end.");
-
-				// https://stackoverflow.com/questions/37005449/how-to-call-erase-with-a-reverse-iterator-using-a-for-loop
-				rit = decltype(rit){movements.erase(std::next(rit).base())};
-			}
-			else
-			{
-				break;
-			}
+			lastMousePositionX = movements.back().destX - movements.back().xDistance;
+			lastMousePositionY = movements.back().destY - movements.back().yDistance;
+			Logger::Print(nature.debug_printer, "Pruning 0-overshoot movement (Movement to target) from the end.");
+			movements.pop_back();
 		}
 		xDistance = xDest - lastMousePositionX;
 		yDistance = yDest - lastMousePositionY;
 		auto distance = std::hypot(xDistance, yDistance);
 		auto movementToTargetFlowTime = nature.getFlowWithTime(distance);
-		auto finalMovementTime = nature.overshootManager->deriveNextMouseMovementTimeMs(movementToTargetFlowTime.second, 0);
+		auto finalMovementTime = Deref(nature.overshootManager).deriveNextMouseMovementTimeMs(movementToTargetFlowTime.second, 0);
 		movements.emplace_back(xDest, yDest, distance, xDistance, yDistance, finalMovementTime, movementToTargetFlowTime.first);
-		Logger::Print(nature.debug_printer, "%d movements returned for move (%d, %d) . (%d, %d)", movements.size(), currentMousePosition.x, currentMousePosition.y, xDest, yDest);
+		Logger::Print(nature.debug_printer, "%d movements returned for move (%d, %d) . (%d, %d)", (int)movements.size(), currentMousePosition.x, currentMousePosition.y, xDest, yDest);
 		return movements;
 	}
 
 private:
 	int xDest;
 	int yDest;
-	MotionNature& nature;	
-	Dimension screenSize;
-
-	int limitByScreenWidth(int value)
-	{
-		return std::max(0, std::min(screenSize.Width - 1, value));
-	}
-
-	int limitByScreenHeight(int value)
-	{
-		return std::max(0, std::min(screenSize.Height - 1, value));
-	}
+	Nature& nature;
+	std::shared_ptr<const ScreenLayout> layout;
 };
 
+using MovementFactory = BasicMovementFactory<MotionNature>;
+
 } // namespace NaturalMouseMotion
\ No newline at end of file
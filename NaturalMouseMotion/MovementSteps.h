@@ -0,0 +1,321 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * One array of MovementSteps, a view into the memory the steps keep
+ */
+template <typename T>
+class StepArray
+{
+public:
+	T *data()
+	{
+		return elements;
+	}
+
+	const T *data() const
+	{
+		return elements;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	T &operator[](size_t i)
+	{
+		return elements[i];
+	}
+
+	const T &operator[](size_t i) const
+	{
+		return elements[i];
+	}
+
+	T &back()
+	{
+		return elements[count - 1];
+	}
+
+	const T &back() const
+	{
+		return elements[count - 1];
+	}
+
+private:
+	friend struct MovementSteps;
+	T *elements{nullptr};
+	size_t count{0};
+};
+
+/**
+ * All steps of a single Movement, stored as structure of arrays.
+ * Element i of every array describes step i, x and y are the final positions the cursor is set to.
+ * The arrays share one block of memory, allocated by the steps or placed by the caller, see place().
+ */
+struct MovementSteps
+{
+	int steps{0};
+	/**
+	 * Nanoseconds from the start of one step to the start of the next. Steps start at multiples of it,
+	 * and every step but the last ends there too; the last ends with the movement.
+	 */
+	double stepNanos{0};
+	/**
+	 * Nanoseconds from the start of the movement to its end
+	 */
+	double endNanos{0};
+	StepArray<double> coveredFraction; // steps + 1 elements, fraction of the distance covered at each step boundary
+	StepArray<double> xStepSize;
+	StepArray<double> yStepSize;
+	StepArray<double> simulatedX;
+	StepArray<double> simulatedY;
+	StepArray<double> completion;
+	StepArray<double> effectFade;
+	StepArray<double> deviationX;
+	StepArray<double> deviationY;
+	StepArray<double> noiseX;
+	StepArray<double> noiseY;
+	StepArray<int> x;
+	StepArray<int> y;
+
+	MovementSteps() = default;
+
+	MovementSteps(const MovementSteps &other)
+	{
+		*this = other;
+	}
+
+	/**
+	 * Copies the steps into memory of their own, even when the other ones were placed
+	 */
+	MovementSteps &operator=(const MovementSteps &other)
+	{
+		if (this != &other)
+		{
+			resize(other.steps);
+			stepNanos = other.stepNanos;
+			endNanos = other.endNanos;
+			if (other.steps > 0)
+			{
+				std::memcpy(memory, other.memory, BytesFor(other.steps));
+			}
+		}
+		return *this;
+	}
+
+	/**
+	 * Bytes of memory the arrays take for count steps
+	 */
+	static size_t BytesFor(int count)
+	{
+		auto n = static_cast<size_t>(count);
+		return (DOUBLE_ARRAYS * n + 1) * sizeof(double) + INT_ARRAYS * n * sizeof(int);
+	}
+
+	/**
+	 * @return the most steps that fit without growing
+	 */
+	int capacity() const
+	{
+		return capacityCount;
+	}
+
+	/**
+	 * @return the most steps a plan may have, limited to the capacity while the memory is placed
+	 */
+	int maxSteps() const
+	{
+		return placed ? capacityCount : std::numeric_limits<int>::max();
+	}
+
+	/**
+	 * Growing doesn't keep the steps, they are all written again by the next plan.
+	 * Placed memory can't grow, more than capacity() steps throw std::length_error.
+	 */
+	void resize(int count)
+	{
+		reserve(count);
+		steps = count;
+		arrange();
+	}
+
+	/**
+	 * Allocates the arrays for count steps, so planning up to count steps doesn't allocate
+	 */
+	void reserve(int count)
+	{
+		if (count <= capacityCount)
+		{
+			return;
+		}
+		if (placed)
+		{
+			throw std::length_error("MovementSteps can't grow beyond the memory they were placed in");
+		}
+		auto doubles = (BytesFor(count) + sizeof(double) - 1) / sizeof(double);
+		owned.reset(new double[doubles]);
+		memory = owned.get();
+		capacityCount = count;
+		arrange();
+	}
+
+	/**
+	 * Moves the arrays into memory the caller keeps for as long as they are used, e.g. memory locked into RAM.
+	 * The memory has to hold BytesFor(count) bytes and be aligned for double. Until unplace() the arrays
+	 * don't grow, plans are limited to count steps. The current steps are dropped.
+	 */
+	void place(void *placedMemory, int count)
+	{
+		owned.reset();
+		memory = placedMemory;
+		capacityCount = count;
+		placed = true;
+		steps = 0;
+		arrange();
+	}
+
+	/**
+	 * Lets go of the placed memory, the arrays are allocated again when next needed
+	 */
+	void unplace()
+	{
+		memory = nullptr;
+		capacityCount = 0;
+		placed = false;
+		steps = 0;
+		arrange();
+	}
+
+	/**
+	 * For BasicRealtimeScope, which places every MovementSteps of its buffers
+	 */
+	template <typename F>
+	void forEachSteps(F f)
+	{
+		f(*this);
+	}
+
+	/**
+	 * @return nanoseconds from the start of the movement to the start of step i, to its end for i == steps
+	 */
+	double startOf(int i) const
+	{
+		return i < steps ? stepNanos * i : endNanos;
+	}
+
+private:
+	static constexpr size_t DOUBLE_ARRAYS = 11;
+	static constexpr size_t INT_ARRAYS = 2;
+
+	std::unique_ptr<double[]> owned{};
+	void *memory{nullptr};
+	int capacityCount{0};
+	bool placed{false};
+
+	/**
+	 * Lays the arrays out one after the other for the current number of steps
+	 */
+	void arrange()
+	{
+		if (!memory)
+		{
+			for (auto v : {&coveredFraction, &xStepSize, &yStepSize, &simulatedX, &simulatedY, &completion, &effectFade, &deviationX, &deviationY, &noiseX, &noiseY})
+			{
+				*v = StepArray<double>{};
+			}
+			x = StepArray<int>{};
+			y = StepArray<int>{};
+			return;
+		}
+		auto n = static_cast<size_t>(steps);
+		auto doubles = static_cast<double *>(memory);
+		coveredFraction.elements = doubles;
+		coveredFraction.count = n + 1;
+		doubles += n + 1;
+		for (auto v : {&xStepSize, &yStepSize, &simulatedX, &simulatedY, &completion, &effectFade, &deviationX, &deviationY, &noiseX, &noiseY})
+		{
+			v->elements = doubles;
+			v->count = n;
+			doubles += n;
+		}
+		auto ints = reinterpret_cast<int *>(doubles);
+		for (auto v : {&x, &y})
+		{
+			v->elements = ints;
+			v->count = n;
+			ints += n;
+		}
+	}
+};
+
+/**
+ * Step buffers a nature keeps for the moves it plays, so moves don't allocate once the buffers have grown
+ * large enough. A move borrows them while it plays; a move of the same nature started meanwhile, e.g. from
+ * the observer, gets buffers of its own instead of overwriting the ones being played.
+ * Copies of a nature start with empty buffers of their own.
+ */
+class StepBuffers
+{
+public:
+	StepBuffers() = default;
+
+	StepBuffers(const StepBuffers &)
+	{
+	}
+
+	StepBuffers &operator=(const StepBuffers &)
+	{
+		return *this;
+	}
+
+	/**
+	 * The buffers for one move, for as long as it lives
+	 */
+	class Lease
+	{
+	public:
+		explicit Lease(StepBuffers &buffers) : lent(buffers.borrowed ? nullptr : &buffers)
+		{
+			if (lent)
+			{
+				lent->borrowed = true;
+			}
+		}
+
+		~Lease()
+		{
+			if (lent)
+			{
+				lent->borrowed = false;
+			}
+		}
+
+		Lease(const Lease &) = delete;
+		Lease &operator=(const Lease &) = delete;
+
+		MovementSteps &get()
+		{
+			return lent ? lent->steps : own;
+		}
+
+	private:
+		StepBuffers *lent;
+		MovementSteps own{};
+	};
+
+private:
+	MovementSteps steps{};
+	bool borrowed{false};
+};
+
+} // namespace NaturalMouseMotion
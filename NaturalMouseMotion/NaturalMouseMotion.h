@@ -1,4 +1,10 @@
 #pragma once
 
 #include "DefaultNature.h"
+#include "XTestSystemCalls.h"
+#include "InputEventSystemCalls.h"
 #include "Move.h"
+#include "MoveAsync.h"
+#include "MovePipeline.h"
+#include "MoveCoroutine.h"
+#include "MotionSimulator.h"
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * Histogram of durations in nanoseconds with constant memory and constant time recording.
+ * Every power of two is split into SUB_BUCKETS buckets, so percentiles are within 25% of the real value,
+ * durations below SUB_BUCKETS nanoseconds and the maximum are exact.
+ */
+class LatencyHistogram
+{
+public:
+	static constexpr size_t SUB_BUCKETS{4};
+	static constexpr size_t BUCKETS{62 * SUB_BUCKETS};
+
+	/**
+	 * @param nanos the duration, negative durations are counted as 0
+	 */
+	void add(int64_t nanos)
+	{
+		auto value = static_cast<uint64_t>(std::max(nanos, static_cast<int64_t>(0)));
+		buckets[bucketOf(value)]++;
+		samples++;
+		sum += value;
+		maxValue = std::max(maxValue, value);
+	}
+
+	uint64_t count() const
+	{
+		return samples;
+	}
+
+	uint64_t total() const
+	{
+		return sum;
+	}
+
+	uint64_t max() const
+	{
+		return maxValue;
+	}
+
+	double mean() const
+	{
+		return samples == 0 ? 0.0 : sum / static_cast<double>(samples);
+	}
+
+	/**
+	 * @param fraction percentile as a fraction, e.g. 0.99 for p99
+	 * @return upper bound of the bucket holding the percentile, never more than max, 0 when empty
+	 */
+	uint64_t percentile(double fraction) const
+	{
+		if (samples == 0)
+		{
+			return 0;
+		}
+		auto rank = std::max(static_cast<uint64_t>(1), static_cast<uint64_t>(fraction * samples + 0.999999));
+		uint64_t seen = 0;
+		for (size_t i = 0; i < BUCKETS; i++)
+		{
+			seen += buckets[i];
+			if (seen >= rank)
+			{
+				return std::min(upperBoundOf(i), maxValue);
+			}
+		}
+		return maxValue;
+	}
+
+	uint64_t p50() const
+	{
+		return percentile(0.5);
+	}
+
+	uint64_t p99() const
+	{
+		return percentile(0.99);
+	}
+
+	/**
+	 * Counts of every bucket, bucket i holds durations from lowerBoundOf(i) to upperBoundOf(i)
+	 */
+	const std::array<uint64_t, BUCKETS> &getBuckets() const
+	{
+		return buckets;
+	}
+
+	static uint64_t lowerBoundOf(size_t bucket)
+	{
+		if (bucket < SUB_BUCKETS)
+		{
+			return bucket;
+		}
+		auto octave = bucket / SUB_BUCKETS + 1;
+		return (SUB_BUCKETS + bucket % SUB_BUCKETS) << (octave - 2);
+	}
+
+	static uint64_t upperBoundOf(size_t bucket)
+	{
+		return bucket + 1 < BUCKETS ? lowerBoundOf(bucket + 1) - 1 : UINT64_MAX;
+	}
+
+private:
+	std::array<uint64_t, BUCKETS> buckets{};
+	uint64_t samples{0};
+	uint64_t sum{0};
+	uint64_t maxValue{0};
+
+	static size_t bucketOf(uint64_t value)
+	{
+		if (value < SUB_BUCKETS)
+		{
+			return static_cast<size_t>(value);
+		}
+		size_t octave = floorLog2(value);
+		auto sub = static_cast<size_t>(value >> (octave - 2)) % SUB_BUCKETS;
+		return std::min((octave - 1) * SUB_BUCKETS + sub, BUCKETS - 1);
+	}
+
+	static size_t floorLog2(uint64_t value)
+	{
+#if defined(__GNUC__)
+		return 63 - __builtin_clzll(value);
+#else
+		size_t log = 0;
+		while (value >>= 1)
+		{
+			log++;
+		}
+		return log;
+#endif
+	}
+};
+
+/**
+ * Which settings of a RealtimeConfig were in effect during the last move requesting them
+ */
+struct RealtimeStatus
+{
+	bool scheduling{false};
+	bool pinned{false};
+	bool memoryLocked{false};
+	bool timerSlack{false};
+
+	/**
+	 * Requested settings that couldn't be applied, over every move, and the error code of the last one
+	 */
+	uint64_t failures{0};
+	int lastError{0};
+};
+
+/**
+ * Describes how movements were played back, accumulated over every move using the nature.
+ * Durations are in nanoseconds of SystemCalls::currentTimeNanos.
+ * Only collected when the nature has stats, otherwise Move doesn't even read the clock for them.
+ */
+struct PlaybackStats
+{
+	/**
+	 * Steps the cursor was set to
+	 */
+	uint64_t emittedSteps{0};
+
+	/**
+	 * Steps skipped because they were already late, see BasicMotionNature::dropLateSteps
+	 */
+	uint64_t droppedSteps{0};
+
+	/**
+	 * Movements cut short because the cursor was moved by something else, see BasicMotionNature::onInterference
+	 */
+	uint64_t interferences{0};
+
+	/**
+	 * How late each emitted step was set compared to the time planned for it
+	 */
+	LatencyHistogram stepLateness;
+
+	/**
+	 * How much later than the deadline each wait between steps returned
+	 */
+	LatencyHistogram oversleep;
+
+	/**
+	 * Time spent in each SystemCalls::setMousePosition and SystemCalls::getMousePosition call
+	 */
+	LatencyHistogram setMousePositionTime;
+	LatencyHistogram getMousePositionTime;
+
+	/**
+	 * Time spent planning the steps of each movement
+	 */
+	LatencyHistogram planningTime;
+
+	/**
+	 * Time from the start of each Move until its first step is emitted
+	 */
+	LatencyHistogram timeToFirstStep;
+
+	/**
+	 * Sum of planned movement times and the sum of the time they actually took to play back
+	 */
+	int64_t plannedNanos{0};
+	int64_t actualNanos{0};
+
+	RealtimeStatus realtime;
+};
+
+} // namespace NaturalMouseMotion
@@ -0,0 +1,232 @@
+#pragma once
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+
+#include "MotionNature.h"
+#include "StepKernel.h"
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * Applies a RealtimeConfig to the calling thread and the step buffers for the lifetime of the scope,
+ * then restores what was there before. Every setting is applied on its own, one that fails is skipped,
+ * logged to the printer and counted in the status.
+ * Buffers provides forEachSteps like MovementSteps does, calling a function with every MovementSteps it holds.
+ */
+template <typename Buffers>
+class BasicRealtimeScope
+{
+public:
+	/**
+	 * @param config the settings, nothing is done when none are enabled
+	 * @param buffers the step buffers to lock into memory
+	 * @param status receives the applied settings and failures, may be nullptr
+	 * @param printer logs settings that couldn't be applied
+	 */
+	BasicRealtimeScope(const RealtimeConfig &config, Buffers &buffers, RealtimeStatus *status, const LoggerPrinterFunc &printer)
+		: buffers(buffers)
+	{
+		if (!config.enabled())
+		{
+			return;
+		}
+		RealtimeStatus applied;
+		if (config.scheduling != RealtimeConfig::Scheduling::Unchanged)
+		{
+			applied.scheduling = report(applyScheduling(config), "real-time scheduling", applied, printer);
+		}
+		if (config.cpu >= 0)
+		{
+			applied.pinned = report(applyAffinity(config.cpu), "CPU pinning", applied, printer);
+		}
+		if (config.lockMemory)
+		{
+			applied.memoryLocked = report(lockBuffers(config.lockedSteps), "locking memory", applied, printer);
+		}
+		if (config.minimalTimerSlack)
+		{
+			applied.timerSlack = report(applyTimerSlack(), "timer slack", applied, printer);
+		}
+		if (status)
+		{
+			applied.failures += status->failures;
+			if (applied.lastError == 0)
+			{
+				applied.lastError = status->lastError;
+			}
+			*status = applied;
+		}
+	}
+
+	~BasicRealtimeScope()
+	{
+#ifdef __linux__
+		if (timerSlackSet)
+		{
+			prctl(PR_SET_TIMERSLACK, savedTimerSlack, 0, 0, 0);
+		}
+		if (memoryLocked)
+		{
+			buffers.forEachSteps([](MovementSteps &steps) { steps.unplace(); });
+			munlock(arena, arenaBytes);
+			munmap(arena, arenaBytes);
+		}
+		if (affinitySet)
+		{
+			pthread_setaffinity_np(pthread_self(), sizeof(savedAffinity), &savedAffinity);
+		}
+		if (schedulingSet)
+		{
+			pthread_setschedparam(pthread_self(), savedPolicy, &savedParam);
+		}
+#endif
+	}
+
+	BasicRealtimeScope(const BasicRealtimeScope &) = delete;
+	BasicRealtimeScope &operator=(const BasicRealtimeScope &) = delete;
+
+private:
+	Buffers &buffers;
+#ifdef __linux__
+	bool schedulingSet{false};
+	bool affinitySet{false};
+	bool memoryLocked{false};
+	bool timerSlackSet{false};
+	void *arena{nullptr};
+	size_t arenaBytes{0};
+	int savedPolicy{0};
+	sched_param savedParam{};
+	cpu_set_t savedAffinity{};
+	int savedTimerSlack{0};
+#endif
+
+	static bool report(int error, const char *setting, RealtimeStatus &applied, const LoggerPrinterFunc &printer)
+	{
+		if (error == 0)
+		{
+			return true;
+		}
+		applied.failures++;
+		applied.lastError = error;
+		Logger::Print(printer, "Playing back without %s: %s", setting, std::strerror(error));
+		return false;
+	}
+
+	/**
+	 * Each returns 0 when applied, otherwise an error code
+	 */
+	int applyScheduling(const RealtimeConfig &config)
+	{
+#ifdef __linux__
+		auto error = pthread_getschedparam(pthread_self(), &savedPolicy, &savedParam);
+		if (error != 0)
+		{
+			return error;
+		}
+		sched_param param{};
+		param.sched_priority = config.priority;
+		error = pthread_setschedparam(pthread_self(), config.scheduling == RealtimeConfig::Scheduling::Fifo ? SCHED_FIFO : SCHED_RR, &param);
+		schedulingSet = error == 0;
+		return error;
+#else
+		(void)config;
+		return ENOSYS;
+#endif
+	}
+
+	int applyAffinity(int cpu)
+	{
+#ifdef __linux__
+		auto error = pthread_getaffinity_np(pthread_self(), sizeof(savedAffinity), &savedAffinity);
+		if (error != 0)
+		{
+			return error;
+		}
+		if (cpu >= CPU_SETSIZE)
+		{
+			return EINVAL;
+		}
+		cpu_set_t affinity;
+		CPU_ZERO(&affinity);
+		CPU_SET(cpu, &affinity);
+		error = pthread_setaffinity_np(pthread_self(), sizeof(affinity), &affinity);
+		affinitySet = error == 0;
+		return error;
+#else
+		(void)cpu;
+		return ENOSYS;
+#endif
+	}
+
+	/**
+	 * Maps pages of their own for the step buffers and locks them, so no other allocation is locked along
+	 * and the buffers can't grow out of the locked range. Locking faults the pages in, so the buffers are
+	 * resident before the first step is planned into them.
+	 */
+	int lockBuffers(int steps)
+	{
+#ifdef __linux__
+		if (steps <= 0)
+		{
+			return EINVAL;
+		}
+		size_t sets = 0;
+		buffers.forEachSteps([&sets](MovementSteps &) { sets++; });
+		auto setBytes = (MovementSteps::BytesFor(steps) + alignof(double) - 1) / alignof(double) * alignof(double);
+		auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		auto bytes = (sets * setBytes + page - 1) / page * page;
+		void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED)
+		{
+			return errno;
+		}
+		if (mlock(memory, bytes) != 0)
+		{
+			auto error = errno;
+			munmap(memory, bytes);
+			return error;
+		}
+		arena = memory;
+		arenaBytes = bytes;
+		auto next = static_cast<char *>(memory);
+		buffers.forEachSteps([&next, setBytes, steps](MovementSteps &set) {
+			set.place(next, steps);
+			next += setBytes;
+		});
+		memoryLocked = true;
+		return 0;
+#else
+		(void)steps;
+		return ENOSYS;
+#endif
+	}
+
+	int applyTimerSlack()
+	{
+#ifdef __linux__
+		savedTimerSlack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+		if (savedTimerSlack < 0 || prctl(PR_SET_TIMERSLACK, 1, 0, 0, 0) != 0)
+		{
+			return errno;
+		}
+		timerSlackSet = true;
+		return 0;
+#else
+		return ENOSYS;
+#endif
+	}
+};
+
+using RealtimeScope = BasicRealtimeScope<MovementSteps>;
+
+} // namespace NaturalMouseMotion
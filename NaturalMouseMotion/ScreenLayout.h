@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * Type used for screen dimensions
+ **/
+struct Dimension
+{
+	int Width;
+	int Height;
+};
+
+/**
+ * Simple coordinates type
+ **/
+template<typename T>
+struct Point
+{
+	T x;
+	T y;
+};
+
+/**
+ * Rectangle of pixels, x and y included, x + width and y + height not
+ */
+struct Rect
+{
+	int x;
+	int y;
+	int width;
+	int height;
+
+	bool contains(Point<int> p) const
+	{
+		return p.x >= x && p.x < x + width && p.y >= y && p.y < y + height;
+	}
+
+	/**
+	 * @return the pixel of the rectangle nearest to p
+	 */
+	Point<int> clamp(Point<int> p) const
+	{
+		return {std::max(x, std::min(x + width - 1, p.x)), std::max(y, std::min(y + height - 1, p.y))};
+	}
+};
+
+/**
+ * The monitors the screen is made of. With several monitors of different sizes or with gaps between them,
+ * parts of their bounding rectangle can't be seen and the cursor can't go there.
+ * Monitors are indexed in a grid on their edges when the layout is made, so finding the monitor of a point
+ * is two binary searches.
+ */
+class ScreenLayout
+{
+public:
+	ScreenLayout() : ScreenLayout(std::vector<Rect>{})
+	{
+	}
+
+	/**
+	 * A single monitor of the given size
+	 */
+	explicit ScreenLayout(Dimension size) : ScreenLayout(std::vector<Rect>{{0, 0, size.Width, size.Height}})
+	{
+	}
+
+	/**
+	 * @param rects the monitor rectangles in screen coordinates, empty ones are left out.
+	 * Where monitors overlap, the point belongs to the first one.
+	 */
+	explicit ScreenLayout(std::vector<Rect> rects)
+	{
+		for (auto &rect : rects)
+		{
+			if (rect.width > 0 && rect.height > 0)
+			{
+				monitors.push_back(rect);
+			}
+		}
+		index();
+	}
+
+	const std::vector<Rect> &getMonitors() const
+	{
+		return monitors;
+	}
+
+	/**
+	 * @return the bounding rectangle of all monitors
+	 */
+	const Rect &getBounds() const
+	{
+		return bounds;
+	}
+
+	/**
+	 * @return true when the monitors cover their bounding rectangle without gaps, so clamping to the bounds is enough
+	 */
+	bool isRectangular() const
+	{
+		return rectangular;
+	}
+
+	/**
+	 * @return the index of the monitor showing p, -1 when no monitor does
+	 */
+	int monitorAt(Point<int> p) const
+	{
+		if (!bounds.contains(p))
+		{
+			return -1;
+		}
+		auto column = std::upper_bound(xEdges.begin(), xEdges.end(), p.x) - xEdges.begin() - 1;
+		auto row = std::upper_bound(yEdges.begin(), yEdges.end(), p.y) - yEdges.begin() - 1;
+		return cells[row * (xEdges.size() - 1) + column];
+	}
+
+	bool contains(Point<int> p) const
+	{
+		return monitorAt(p) >= 0;
+	}
+
+	/**
+	 * @return the visible pixel nearest to p, p itself when it is visible
+	 */
+	Point<int> clamp(Point<int> p) const
+	{
+		if (rectangular)
+		{
+			return bounds.clamp(p);
+		}
+		if (contains(p))
+		{
+			return p;
+		}
+		Point<int> nearest = p;
+		int64_t nearestDistance = INT64_MAX;
+		for (auto &monitor : monitors)
+		{
+			auto clamped = monitor.clamp(p);
+			int64_t dx = clamped.x - p.x;
+			int64_t dy = clamped.y - p.y;
+			if (dx * dx + dy * dy < nearestDistance)
+			{
+				nearestDistance = dx * dx + dy * dy;
+				nearest = clamped;
+			}
+		}
+		return nearest;
+	}
+
+private:
+	std::vector<Rect> monitors{};
+	Rect bounds{0, 0, 0, 0};
+	bool rectangular{true};
+	// Sorted distinct monitor edges, the grid cell between edges i and i + 1 of both is shown by a single monitor or none
+	std::vector<int> xEdges{};
+	std::vector<int> yEdges{};
+	std::vector<int> cells{};
+
+	void index()
+	{
+		if (monitors.empty())
+		{
+			return;
+		}
+		int right = monitors[0].x + monitors[0].width;
+		int bottom = monitors[0].y + monitors[0].height;
+		bounds = monitors[0];
+		for (auto &monitor : monitors)
+		{
+			bounds.x = std::min(bounds.x, monitor.x);
+			bounds.y = std::min(bounds.y, monitor.y);
+			right = std::max(right, monitor.x + monitor.width);
+			bottom = std::max(bottom, monitor.y + monitor.height);
+			xEdges.push_back(monitor.x);
+			xEdges.push_back(monitor.x + monitor.width);
+			yEdges.push_back(monitor.y);
+			yEdges.push_back(monitor.y + monitor.height);
+		}
+		bounds.width = right - bounds.x;
+		bounds.height = bottom - bounds.y;
+		for (auto edges : {&xEdges, &yEdges})
+		{
+			std::sort(edges->begin(), edges->end());
+			edges->erase(std::unique(edges->begin(), edges->end()), edges->end());
+		}
+
+		auto columns = xEdges.size() - 1;
+		cells.assign(columns * (yEdges.size() - 1), -1);
+		for (int i = (int)monitors.size() - 1; i >= 0; i--)
+		{
+			auto &monitor = monitors[i];
+			auto firstColumn = std::lower_bound(xEdges.begin(), xEdges.end(), monitor.x) - xEdges.begin();
+			auto lastColumn = std::lower_bound(xEdges.begin(), xEdges.end(), monitor.x + monitor.width) - xEdges.begin();
+			auto firstRow = std::lower_bound(yEdges.begin(), yEdges.end(), monitor.y) - yEdges.begin();
+			auto lastRow = std::lower_bound(yEdges.begin(), yEdges.end(), monitor.y + monitor.height) - yEdges.begin();
+			for (auto row = firstRow; row < lastRow; row++)
+			{
+				for (auto column = firstColumn; column < lastColumn; column++)
+				{
+					cells[row * columns + column] = i;
+				}
+			}
+		}
+		rectangular = std::find(cells.begin(), cells.end(), -1) == cells.end();
+	}
+};
+
+} // namespace NaturalMouseMotion
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * Fixed ring of slots handed from one producer thread to one consumer thread without locks.
+ * Slots are written and read in place and never destroyed, so buffers inside them are reused.
+ * The producer claims a free slot, fills it and publishes it; the consumer takes the oldest published slot,
+ * reads it and releases it back to the producer.
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	/**
+	 * Producer only
+	 * @return the slot to fill, nullptr when every slot is waiting for the consumer
+	 */
+	T *claim()
+	{
+		auto head = produced.value.load(std::memory_order_relaxed);
+		if (head - consumed.value.load(std::memory_order_acquire) == Capacity)
+		{
+			return nullptr;
+		}
+		return &slots[head & (Capacity - 1)];
+	}
+
+	/**
+	 * Producer only, hands the claimed slot to the consumer
+	 */
+	void publish()
+	{
+		produced.value.store(produced.value.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Consumer only
+	 * @return the oldest published slot, nullptr when there is none
+	 */
+	T *front()
+	{
+		auto tail = consumed.value.load(std::memory_order_relaxed);
+		if (tail == produced.value.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+		return &slots[tail & (Capacity - 1)];
+	}
+
+	/**
+	 * Consumer only, gives the front slot back to the producer
+	 */
+	void release()
+	{
+		consumed.value.store(consumed.value.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Not synchronized, for use while neither thread is using the ring
+	 */
+	template <typename F>
+	void forEachSlot(F f)
+	{
+		for (auto &slot : slots)
+		{
+			f(slot);
+		}
+	}
+
+private:
+	static constexpr size_t CACHE_LINE{64};
+
+	/**
+	 * Padded rather than aligned, so rings can be allocated with new before C++17
+	 */
+	struct Counter
+	{
+		std::atomic<size_t> value{0};
+		char padding[CACHE_LINE - sizeof(std::atomic<size_t>)];
+	};
+
+	std::array<T, Capacity> slots{};
+	// On cache lines of their own, so the threads don't invalidate each other's line on every hand-off
+	Counter produced{};
+	Counter consumed{};
+};
+
+} // namespace NaturalMouseMotion
@@ -0,0 +1,320 @@
+#pragma once
+
+#if !defined(NATURALMOUSEMOTION_NO_SIMD) && defined(__AVX2__)
+#define NATURALMOUSEMOTION_AVX2
+#include <immintrin.h>
+#elif !defined(NATURALMOUSEMOTION_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define NATURALMOUSEMOTION_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "MotionNature.h"
+#include "MovementFactory.h"
+#include "MovementSteps.h"
+
+namespace NaturalMouseMotion
+{
+
+/**
+ * Computes every step of a Movement in a single pass before the movement is played back,
+ * so playback only has to read the precomputed positions.
+ * The flow, effect fade and deviation arithmetic is vectorized with AVX2 or SSE2 when available,
+ * noise and deviation providers are called once per step in order as they are user supplied and noise accumulates.
+ */
+struct StepKernel
+{
+	/**
+	 * Number of steps is calculated from the movement time and limited by minimal amount of steps
+	 * (should have at least MIN_STEPS) and distance (shouldn't have more steps than pixels travelled).
+	 * With an emission rate there is a step per tick of the rate instead, and at least one. When that would be
+	 * more steps than pixels, every step spans the same number of ticks.
+	 * No more than limit steps are taken, longer steps cover the movement then.
+	 */
+	template <typename Nature>
+	static int StepsFor(const Nature &nature, const Movement &movement, int limit = std::numeric_limits<int>::max())
+	{
+		if (nature.emissionRateHz > 0)
+		{
+			auto ticks = RateTicks(nature, movement);
+			auto ticksPerStep = RateTicksPerStep(ticks, std::min((int)std::ceil(movement.distance), limit));
+			return ticksPerStep > 0 ? (ticks + ticksPerStep - 1) / ticksPerStep : 0;
+		}
+		return std::min(limit, (int)std::ceil(std::min(movement.distance, std::max((double)movement.time / nature.timeToStepsDivider, (double)nature.minSteps))));
+	}
+
+	/**
+	 * Nanoseconds from the start of one step to the start of the next, see MovementSteps::stepNanos.
+	 * Steps take equal parts of the movement time, or with an emission rate start on the ticks of the rate.
+	 */
+	template <typename Nature>
+	static double StepNanos(const Nature &nature, const Movement &movement, int steps)
+	{
+		if (steps <= 0)
+		{
+			return 0;
+		}
+		if (nature.emissionRateHz > 0)
+		{
+			// StepsFor spreads the ticks evenly, so this is the number of ticks per step it chose
+			return RateTicksPerStep(RateTicks(nature, movement), steps) * 1.0e9 / nature.emissionRateHz;
+		}
+		return movement.time * (double)NANOS_IN_MILLI / steps;
+	}
+
+	/**
+	 * Plans the movement starting from mousePosition into out.
+	 *
+	 * @param nature the nature that defines how mouse is moved
+	 * @param movement the movement to plan
+	 * @param mousePosition the position the movement starts from
+	 * @param screenSize positions are limited to the screen
+	 * @param out receives the steps, buffers are reused when large enough
+	 */
+	template <typename Nature>
+	static void Plan(Nature &nature, const Movement &movement, Point<int> mousePosition, Dimension screenSize, MovementSteps &out)
+	{
+		Plan(nature, movement, mousePosition, Rect{0, 0, screenSize.Width, screenSize.Height}, nullptr, out);
+	}
+
+	/**
+	 * Plans the movement like above, with positions limited to the monitors of the layout.
+	 * Steps that would fall between monitors are moved to the nearest visible pixel, which only costs
+	 * a lookup per step when the monitors don't cover their bounding rectangle.
+	 */
+	template <typename Nature>
+	static void Plan(Nature &nature, const Movement &movement, Point<int> mousePosition, const ScreenLayout &layout, MovementSteps &out)
+	{
+		Plan(nature, movement, mousePosition, layout.getBounds(), layout.isRectangular() ? nullptr : &layout, out);
+	}
+
+private:
+	template <typename Nature>
+	static int RateTicks(const Nature &nature, const Movement &movement)
+	{
+		return (int)std::ceil(std::max(movement.time * nature.emissionRateHz / 1000.0, 1.0));
+	}
+
+	static int RateTicksPerStep(int ticks, int maxSteps)
+	{
+		return maxSteps > 0 ? (ticks + maxSteps - 1) / maxSteps : 0;
+	}
+
+	template <typename Nature>
+	static void Plan(Nature &nature, const Movement &movement, Point<int> mousePosition, Rect bounds, const ScreenLayout *layout, MovementSteps &out)
+	{
+		auto steps = StepsFor(nature, movement, out.maxSteps());
+		out.resize(steps);
+		out.stepNanos = StepNanos(nature, movement, steps);
+		out.endNanos = movement.time * (double)NANOS_IN_MILLI;
+
+		double deviationMultiplierX = (nature.random() - 0.5) * 2;
+		double deviationMultiplierY = (nature.random() - 0.5) * 2;
+		if (steps <= 0)
+		{
+			return;
+		}
+
+		// All steps take equal amount of time, step i ends when (i + 1) / steps of the time has passed.
+		// With an emission rate step i ends on its tick instead, and the last one when the time has passed.
+		double tickFraction = nature.emissionRateHz > 0 && movement.time > 0 ? out.stepNanos / (movement.time * (double)NANOS_IN_MILLI) : 0;
+		for (int i = 0; i <= steps; i++)
+		{
+			auto timeFraction = tickFraction > 0 ? std::min(1.0, i * tickFraction) : i / (double)steps;
+			out.coveredFraction[i] = movement.flow->getDistanceCovered(1.0, timeFraction);
+		}
+
+		FlowPass(out, mousePosition, movement.xDistance, movement.yDistance, movement.distance);
+		FadePass(out, nature.effectFadeSteps);
+
+		double noiseX = 0;
+		double noiseY = 0;
+		for (int i = 0; i < steps; i++)
+		{
+			Logger::Print(nature.debug_printer, "Step: x: %f y: %f tc: %f c: %f", out.xStepSize[i], out.yStepSize[i], i / (double)steps, out.completion[i]);
+
+			auto noise = nature.getNoise(nature.random, out.xStepSize[i], out.yStepSize[i]);
+			auto deviation = nature.getDeviation(movement.distance, out.completion[i]);
+
+			noiseX += noise.y;
+			noiseY += noise.y;
+			out.noiseX[i] = noiseX;
+			out.noiseY[i] = noiseY;
+			out.deviationX[i] = deviation.x * deviationMultiplierX;
+			out.deviationY[i] = deviation.y * deviationMultiplierY;
+
+			Logger::Print(nature.debug_printer, "EffectFadeMultiplier: %f", out.effectFade[i]);
+			Logger::Print(nature.debug_printer, "SimulatedMouse: [%f, %f]", out.simulatedX[i], out.simulatedY[i]);
+		}
+
+		PositionPass(out.simulatedX.data(), out.deviationX.data(), out.noiseX.data(), out.effectFade.data(), movement.destX, bounds.x, bounds.x + bounds.width, steps, out.x.data());
+		PositionPass(out.simulatedY.data(), out.deviationY.data(), out.noiseY.data(), out.effectFade.data(), movement.destY, bounds.y, bounds.y + bounds.height, steps, out.y.data());
+		if (layout)
+		{
+			for (int i = 0; i < steps; i++)
+			{
+				auto position = layout->clamp({out.x[i], out.y[i]});
+				out.x[i] = position.x;
+				out.y[i] = position.y;
+			}
+		}
+	}
+
+	/**
+	 * Step sizes, simulated (straight line) positions and distance completion of every step.
+	 */
+	static void FlowPass(MovementSteps &out, Point<int> start, double xDistance, double yDistance, double distance)
+	{
+		const double *covered = out.coveredFraction.data();
+		double *xStep = out.xStepSize.data();
+		double *yStep = out.yStepSize.data();
+		double *simX = out.simulatedX.data();
+		double *simY = out.simulatedY.data();
+		double *completion = out.completion.data();
+		int i = 0;
+#if defined(NATURALMOUSEMOTION_AVX2)
+		const __m256d xd = _mm256_set1_pd(xDistance), yd = _mm256_set1_pd(yDistance);
+		const __m256d sx = _mm256_set1_pd(start.x), sy = _mm256_set1_pd(start.y);
+		const __m256d dist = _mm256_set1_pd(distance), one = _mm256_set1_pd(1.0);
+		for (; i + 4 <= out.steps; i += 4)
+		{
+			__m256d from = _mm256_loadu_pd(covered + i);
+			__m256d until = _mm256_loadu_pd(covered + i + 1);
+			__m256d delta = _mm256_sub_pd(until, from);
+			__m256d cx = _mm256_mul_pd(xd, until), cy = _mm256_mul_pd(yd, until);
+			_mm256_storeu_pd(xStep + i, _mm256_mul_pd(xd, delta));
+			_mm256_storeu_pd(yStep + i, _mm256_mul_pd(yd, delta));
+			_mm256_storeu_pd(simX + i, _mm256_add_pd(sx, cx));
+			_mm256_storeu_pd(simY + i, _mm256_add_pd(sy, cy));
+			__m256d length = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(cx, cx), _mm256_mul_pd(cy, cy)));
+			_mm256_storeu_pd(completion + i, _mm256_min_pd(one, _mm256_div_pd(length, dist)));
+		}
+#elif defined(NATURALMOUSEMOTION_SSE2)
+		const __m128d xd = _mm_set1_pd(xDistance), yd = _mm_set1_pd(yDistance);
+		const __m128d sx = _mm_set1_pd(start.x), sy = _mm_set1_pd(start.y);
+		const __m128d dist = _mm_set1_pd(distance), one = _mm_set1_pd(1.0);
+		for (; i + 2 <= out.steps; i += 2)
+		{
+			__m128d from = _mm_loadu_pd(covered + i);
+			__m128d until = _mm_loadu_pd(covered + i + 1);
+			__m128d delta = _mm_sub_pd(until, from);
+			__m128d cx = _mm_mul_pd(xd, until), cy = _mm_mul_pd(yd, until);
+			_mm_storeu_pd(xStep + i, _mm_mul_pd(xd, delta));
+			_mm_storeu_pd(yStep + i, _mm_mul_pd(yd, delta));
+			_mm_storeu_pd(simX + i, _mm_add_pd(sx, cx));
+			_mm_storeu_pd(simY + i, _mm_add_pd(sy, cy));
+			__m128d length = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(cx, cx), _mm_mul_pd(cy, cy)));
+			_mm_storeu_pd(completion + i, _mm_min_pd(one, _mm_div_pd(length, dist)));
+		}
+#endif
+		for (; i < out.steps; i++)
+		{
+			double delta = covered[i + 1] - covered[i];
+			double cx = xDistance * covered[i + 1];
+			double cy = yDistance * covered[i + 1];
+			xStep[i] = xDistance * delta;
+			yStep[i] = yDistance * delta;
+			simX[i] = start.x + cx;
+			simY[i] = start.y + cy;
+			completion[i] = std::min(1.0, std::sqrt(cx * cx + cy * cy) / distance);
+		}
+	}
+
+	/**
+	 * Effect fade multiplier, a value from 0 to 1, when effectFadeSteps remaining steps, starts to decrease to 0 linearly
+	 * This is here so noise and deviation wouldn't add offset to mouse final position, when we need accuracy.
+	 */
+	static void FadePass(MovementSteps &out, int effectFadeSteps)
+	{
+		double *fade = out.effectFade.data();
+		const double fadeSteps = effectFadeSteps;
+		// effectFadeStep = max(i - fadeStart, 0)
+		const double fadeStart = out.steps - effectFadeSteps - 1;
+		int i = 0;
+#if defined(NATURALMOUSEMOTION_AVX2)
+		const __m256d vFadeSteps = _mm256_set1_pd(fadeSteps), vFadeStart = _mm256_set1_pd(fadeStart);
+		const __m256d zero = _mm256_setzero_pd(), four = _mm256_set1_pd(4.0);
+		__m256d index = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+		for (; i + 4 <= out.steps; i += 4)
+		{
+			__m256d fadeStep = _mm256_max_pd(_mm256_sub_pd(index, vFadeStart), zero);
+			_mm256_storeu_pd(fade + i, _mm256_div_pd(_mm256_sub_pd(vFadeSteps, fadeStep), vFadeSteps));
+			index = _mm256_add_pd(index, four);
+		}
+#elif defined(NATURALMOUSEMOTION_SSE2)
+		const __m128d vFadeSteps = _mm_set1_pd(fadeSteps), vFadeStart = _mm_set1_pd(fadeStart);
+		const __m128d zero = _mm_setzero_pd(), two = _mm_set1_pd(2.0);
+		__m128d index = _mm_set_pd(1.0, 0.0);
+		for (; i + 2 <= out.steps; i += 2)
+		{
+			__m128d fadeStep = _mm_max_pd(_mm_sub_pd(index, vFadeStart), zero);
+			_mm_storeu_pd(fade + i, _mm_div_pd(_mm_sub_pd(vFadeSteps, fadeStep), vFadeSteps));
+			index = _mm_add_pd(index, two);
+		}
+#endif
+		for (; i < out.steps; i++)
+		{
+			double fadeStep = std::max(i - fadeStart, 0.0);
+			fade[i] = (fadeSteps - fadeStep) / fadeSteps;
+		}
+	}
+
+	/**
+	 * Final position on one axis: simulated position with faded deviation and noise, rounded towards the
+	 * movement destination and limited to [low, limit).
+	 */
+	static void PositionPass(const double *simulated, const double *deviation, const double *noise, const double *fade, int dest, int low, int limit, int steps, int *out)
+	{
+		int i = 0;
+#if defined(NATURALMOUSEMOTION_AVX2)
+		const __m256d vDest = _mm256_set1_pd(dest), vMax = _mm256_set1_pd(limit - 1), vMin = _mm256_set1_pd(low);
+		for (; i + 4 <= steps; i += 4)
+		{
+			__m256d f = _mm256_loadu_pd(fade + i);
+			__m256d v = _mm256_add_pd(
+				_mm256_add_pd(_mm256_loadu_pd(simulated + i), _mm256_mul_pd(_mm256_loadu_pd(deviation + i), f)),
+				_mm256_mul_pd(_mm256_loadu_pd(noise + i), f));
+			__m256d towardsUp = _mm256_cmp_pd(vDest, v, _CMP_GT_OQ);
+			__m256d rounded = _mm256_blendv_pd(_mm256_floor_pd(v), _mm256_ceil_pd(v), towardsUp);
+			rounded = _mm256_min_pd(_mm256_max_pd(rounded, vMin), vMax);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm256_cvttpd_epi32(rounded));
+		}
+#elif defined(NATURALMOUSEMOTION_SSE2)
+		const __m128d vDest = _mm_set1_pd(dest), vMax = _mm_set1_pd(limit - 1), vMin = _mm_set1_pd(low), one = _mm_set1_pd(1.0);
+		for (; i + 2 <= steps; i += 2)
+		{
+			__m128d f = _mm_loadu_pd(fade + i);
+			__m128d v = _mm_add_pd(
+				_mm_add_pd(_mm_loadu_pd(simulated + i), _mm_mul_pd(_mm_loadu_pd(deviation + i), f)),
+				_mm_mul_pd(_mm_loadu_pd(noise + i), f));
+			// SSE2 has no floor/ceil, correct the truncated value instead
+			__m128d truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(v));
+			__m128d floor = _mm_sub_pd(truncated, _mm_and_pd(_mm_cmpgt_pd(truncated, v), one));
+			__m128d ceil = _mm_add_pd(truncated, _mm_and_pd(_mm_cmplt_pd(truncated, v), one));
+			__m128d towardsUp = _mm_cmpgt_pd(vDest, v);
+			__m128d rounded = _mm_or_pd(_mm_and_pd(towardsUp, ceil), _mm_andnot_pd(towardsUp, floor));
+			rounded = _mm_min_pd(_mm_max_pd(rounded, vMin), vMax);
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_cvttpd_epi32(rounded));
+		}
+#endif
+		for (; i < steps; i++)
+		{
+			auto value = roundTowards(simulated[i] + deviation[i] * fade[i] + noise[i] * fade[i], dest);
+			out[i] = std::max(low, std::min(limit - 1, value));
+		}
+	}
+
+	static int roundTowards(double value, int target)
+	{
+		if (target > value)
+			return (int)std::ceil(value);
+		else
+			return (int)std::floor(value);
+	}
+};
+
+} // namespace NaturalMouseMotion
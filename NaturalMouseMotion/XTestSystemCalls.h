@@ -0,0 +1,183 @@
+#pragma once
+
+/**
+ * X11 backend moving the pointer with XTest motion events. Needs libXtst, define NATURAL_MOUSE_MOTION_XTEST
+ * and link it to use it; the CMake build does so when FindX11 finds XTest.
+ */
+#if defined(__linux__) && defined(NATURAL_MOUSE_MOTION_XTEST)
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "X11/extensions/XTest.h"
+
+#include "DefaultProvider.h"
+
+namespace NaturalMouseMotion
+{
+namespace DefaultProvider
+{
+
+/**
+ * Like DefaultSystemCalls on Linux, but every step is a single XTest motion event queued in the client.
+ * Input is selected once, and the queued events are flushed when playback is about to wait for the next
+ * step deadline, rather than with every position.
+ */
+struct XTestSystemCalls final : public SystemCalls
+{
+	Display *display;
+	std::vector<Window> root_windows;
+	int screen;
+
+	XTestSystemCalls()
+	{
+		display = XOpenDisplay(nullptr);
+		if (!display)
+		{
+			throw std::runtime_error("Can't open the X display");
+		}
+		int eventBase, errorBase, major, minor;
+		if (!XTestQueryExtension(display, &eventBase, &errorBase, &major, &minor))
+		{
+			XCloseDisplay(display);
+			throw std::runtime_error("X server has no XTest extension");
+		}
+		screen = XDefaultScreen(display);
+
+		int number_of_screens = XScreenCount(display);
+		for (int i = 0; i < number_of_screens; i++)
+		{
+			root_windows.push_back(XRootWindow(display, i));
+		}
+		XSelectInput(display, root_windows[screen], KeyReleaseMask | X11ScreenGeometry::EventMask());
+		geometry.reset(new X11ScreenGeometry(display, root_windows[screen], screen));
+		pointerRoot = screen;
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+		// The motion events sent here come as raw motion of the XTest pointer, which other XTest clients share
+		rawMotion.reset(new X11RawMotionListener(display, root_windows[screen], "Virtual core XTEST pointer"));
+#endif
+	}
+
+	~XTestSystemCalls()
+	{
+		XCloseDisplay(display);
+	}
+
+	XTestSystemCalls(const XTestSystemCalls &) = delete;
+	XTestSystemCalls &operator=(const XTestSystemCalls &) = delete;
+
+	Dimension getScreenSize() override
+	{
+		return geometry->get();
+	}
+
+	std::shared_ptr<const ScreenLayout> getScreenLayout() override
+	{
+		return geometry->getLayout();
+	}
+
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+	bool takeForeignMotion() override
+	{
+		return rawMotion->take();
+	}
+
+	void watchForeignMotion(bool watching) override
+	{
+		rawMotion->watch(watching);
+	}
+#endif
+
+	void setMousePosition(int x, int y) override
+	{
+		XTestFakeMotionEvent(display, screen, x, y, CurrentTime);
+		pending = true;
+	}
+
+	/**
+	 * Querying the pointer flushes the queued motion events first, so the position includes them.
+	 * The root window the pointer was found on last time is asked first.
+	 */
+	Point<int> getMousePosition() override
+	{
+		pending = false;
+		Window window_returned;
+		int root_x, root_y;
+		int win_x, win_y;
+		unsigned int mask_return;
+
+		for (size_t i = 0; i < root_windows.size(); i++)
+		{
+			auto root = (pointerRoot + i) % root_windows.size();
+			if (XQueryPointer(display, root_windows[root], &window_returned,
+					&window_returned, &root_x, &root_y, &win_x, &win_y,
+					&mask_return))
+			{
+				pointerRoot = root;
+				return {root_x, root_y};
+			}
+		}
+		// No mouse found
+		return {0, 0};
+	}
+
+	time_type currentTimeMillis() override
+	{
+		return SteadyClock::Nanos() / NANOS_IN_MILLI;
+	}
+
+	void sleep(time_type time) override
+	{
+		flush();
+		std::this_thread::sleep_for(std::chrono::milliseconds(time));
+	}
+
+	time_type currentTimeNanos() override
+	{
+		return SteadyClock::Nanos();
+	}
+
+	void sleepNanos(time_type nanos) override
+	{
+		flush();
+		SteadyClock::SleepNanos(nanos, spinNanos);
+	}
+
+	void sleepUntilNanos(time_type deadline) override
+	{
+		flush();
+		SteadyClock::SleepUntilNanos(deadline, spinNanos);
+	}
+
+	/**
+	 * Sends the queued motion events to the server
+	 */
+	void flush()
+	{
+		if (pending)
+		{
+			XFlush(display);
+			pending = false;
+		}
+	}
+
+	/**
+	 * Part of every step wait that is spun, trading CPU time for accurate step timing
+	 */
+	time_type spinNanos{SteadyClock::DEFAULT_SPIN_NANOS};
+
+private:
+	bool pending{false};
+	std::unique_ptr<X11ScreenGeometry> geometry;
+	// Index of the root window the pointer was last found on
+	size_t pointerRoot{0};
+#ifdef NATURAL_MOUSE_MOTION_XINPUT2
+	std::unique_ptr<X11RawMotionListener> rawMotion;
+#endif
+};
+
+} // namespace DefaultProvider
+} // namespace NaturalMouseMotion
+
+#endif
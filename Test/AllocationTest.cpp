@@ -0,0 +1,177 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+// Counts every allocation of the test binary, tests only look at the difference during a call.
+// Atomic as threads of other tests allocate too.
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    std::free(p);
+}
+#endif
+
+// Unlike MockSystemCalls doesn't record every position, which would allocate
+struct NonAllocatingSystemCalls : public SystemCalls
+{
+    Point<int> position{0, 0};
+    int positionsSet{0};
+    // Handed out to every move, the default layout is made anew for each
+    std::shared_ptr<const ScreenLayout> layout{std::make_shared<const ScreenLayout>(Dimension{800, 500})};
+
+    time_type currentTimeMillis() override
+    {
+        return 0;
+    }
+    void sleep(time_type /* time */) override
+    {
+    }
+    Dimension getScreenSize() override
+    {
+        return {800, 500};
+    }
+    void setMousePosition(int x, int y) override
+    {
+        position = {x, y};
+        positionsSet++;
+    }
+    Point<int> getMousePosition() override
+    {
+        return position;
+    }
+    std::shared_ptr<const ScreenLayout> getScreenLayout() override
+    {
+        return layout;
+    }
+};
+
+static MotionNature NewAllocationNature(std::shared_ptr<NonAllocatingSystemCalls> systemCalls)
+{
+    auto nature = NewTestNature(systemCalls, RandomStream{DefaultProvider::FastRandomProvider(3)});
+    nature.getFlowWithTime = [](double) -> std::pair<const Flow *, time_type> {
+        static Flow flow{FlowTemplates::variatingFlow()};
+        return {&flow, 300};
+    };
+    SetOvershoots(nature, 3, nature.random);
+    return nature;
+}
+
+TEST(AllocationTest, countsAllocations)
+{
+    size_t before = allocations;
+    auto value = std::unique_ptr<int>(new int(1));
+    EXPECT_EQ(1u, allocations - before);
+}
+
+TEST(AllocationTest, moveDoesNotAllocateAfterWarmUp)
+{
+    auto systemCalls = std::make_shared<NonAllocatingSystemCalls>();
+    auto nature = NewAllocationNature(systemCalls);
+    Move(nature, 700, 400);
+
+    size_t before = allocations;
+    Move(nature, 20, 30);
+    Move(nature, 650, 450);
+    size_t after = allocations;
+
+    EXPECT_EQ(0u, after - before);
+    EXPECT_EQ(650, systemCalls->position.x);
+    EXPECT_EQ(450, systemCalls->position.y);
+    EXPECT_TRUE(systemCalls->positionsSet > 0);
+}
+
+TEST(AllocationTest, moveFromTheObserverDoesNotOverwriteTheStepsBeingPlayed)
+{
+    auto systemCalls = std::make_shared<NonAllocatingSystemCalls>();
+    auto nature = NewAllocationNature(systemCalls);
+    nature.random = RandomStream{MockRandomProvider({0.5})};
+    std::static_pointer_cast<DefaultProvider::DefaultOvershootManager>(nature.overshootManager)->overshoots = 0;
+    std::vector<Point<int>> alone;
+    nature.observer = [&alone](int x, int y) { alone.push_back({x, y}); };
+    Move(nature, 700, 400);
+
+    systemCalls->position = {0, 0};
+    std::vector<Point<int>> outer;
+    bool nested = false;
+    bool movedFromObserver = false;
+    nature.observer = [&](int x, int y) {
+        if (nested)
+        {
+            return;
+        }
+        outer.push_back({x, y});
+        if (!movedFromObserver)
+        {
+            movedFromObserver = true;
+            nested = true;
+            Move(nature, 100, 450);
+            nested = false;
+        }
+    };
+    Move(nature, 700, 400);
+
+    ASSERT_EQ(alone.size(), outer.size());
+    for (size_t i = 0; i < alone.size(); i++)
+    {
+        EXPECT_EQ(alone[i].x, outer[i].x);
+        EXPECT_EQ(alone[i].y, outer[i].y);
+    }
+    EXPECT_EQ(700, systemCalls->position.x);
+    EXPECT_EQ(400, systemCalls->position.y);
+}
+
+TEST(AllocationTest, disabledLoggerDoesNotAllocate)
+{
+    LoggerPrinterFunc printer = nullptr;
+    size_t before = allocations;
+    Logger::Print(printer, "A message that is longer than any small string buffer: %d, %f", 42, 1.5);
+    EXPECT_EQ(0u, allocations - before);
+}
+
+TEST(AllocationTest, loggerFormatsLongMessages)
+{
+    std::string printed;
+    LoggerPrinterFunc printer = [&printed](const std::string str) { printed = str; };
+    Logger::Print(printer, "%d %s", 7, "short");
+    EXPECT_EQ("7 short", printed);
+    Logger::Print(printer, "%300d", 1);
+    EXPECT_EQ(300u, printed.size());
+    EXPECT_EQ('1', printed.back());
+}
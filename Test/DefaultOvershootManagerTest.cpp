@@ -87,4 +87,15 @@ TEST(DefaultOvershootManagerTest, nextMouseMovementTimeHasMinValue)
       auto nextTime = manager.deriveNextMouseMovementTimeMs(1000, 3);
       EXPECT_EQ(1500, nextTime);
     }
-}
\ No newline at end of file
+}
+TEST(DefaultOvershootManagerTest, drawsFromSharedRandomStream)
+{
+    auto random = RandomStream{MockRandomProvider({0.1, 0.2, 0.3, 0.4, 0.5})};
+    DefaultProvider::DefaultOvershootManager manager(random);
+
+    manager.getOvershootAmount(1000, 500, 1000, 1);
+    // The manager advanced the stream it shares with the caller, it didn't draw from a copy
+    EXPECT_EQ(0.3, random());
+    manager.getOvershootAmount(1000, 500, 1000, 1);
+    EXPECT_EQ(0.1, random());
+}
@@ -1,9 +1,14 @@
 #include <vector>
+#include <cmath>
+#include <type_traits>
 #include "Flow.h"
+#include "FlowTemplates.h"
 #include "gtest/gtest.h"
 
 using NaturalMouseMotion::Flow;
 using NaturalMouseMotion::FlowCharacteristicsContainer;
+using NaturalMouseMotion::FlowTemplate;
+using NaturalMouseMotion::FlowTemplates;
 
 static constexpr double SMALL_DELTA = 10e-6;
 
@@ -163,3 +168,125 @@ TEST(FlowTest, stepsAddUpToDistance_constantFlow_characteristics_to_steps_not_di
     double sum = step1 + step2 + step3 + step4 + step5;
     EXPECT_NEAR(500.0, sum, SMALL_DELTA);
 }
+
+
+// Step size as calculated by walking every bucket in the range, the way Flow used to do it.
+double bucketWalkStepSize(const Flow &flow, double distance, int steps, double completion)
+{
+    auto buckets = flow.getFlowCharacteristics();
+    auto completionStep = 1.0 / steps;
+    auto bucketFrom = (completion * buckets.size());
+    auto bucketUntil = ((completion + completionStep) * buckets.size());
+    double sum = 0;
+    for (auto i = static_cast<int>(bucketFrom); i < bucketUntil && i < static_cast<int>(buckets.size()); i++)
+    {
+        auto value = buckets[i];
+        double endMultiplier = 1;
+        double startMultiplier = 0;
+        if (bucketUntil < i + 1)
+        {
+            endMultiplier = bucketUntil - static_cast<int>(bucketUntil);
+        }
+        if (static_cast<int>(bucketFrom) == i)
+        {
+            startMultiplier = bucketFrom - static_cast<int>(bucketFrom);
+        }
+        value *= endMultiplier - startMultiplier;
+        sum += value;
+    }
+    return sum * distance / (buckets.size() * 100);
+}
+
+TEST(FlowTest, stepSizeMatchesBucketWalkForAllTemplates)
+{
+    std::vector<Flow> flows = {
+        Flow(FlowTemplates::variatingFlow()),
+        Flow(FlowTemplates::interruptedFlow()),
+        Flow(FlowTemplates::interruptedFlow2()),
+        Flow(FlowTemplates::slowStartupFlow()),
+        Flow(FlowTemplates::slowStartup2Flow()),
+        Flow(FlowTemplates::jaggedFlow()),
+        Flow(FlowTemplates::stoppingFlow()),
+        Flow(FlowTemplates::adjustingFlow()),
+        Flow(FlowTemplates::constantSpeed()),
+    };
+
+    for (auto &flow : flows)
+    {
+        for (int steps : {1, 3, 7, 10, 13, 64, 100, 101, 250})
+        {
+            double sum = 0.0;
+            for (int i = 0; i < steps; i++)
+            {
+                double completion = i / (double)steps;
+                double step = flow.getStepSize(500, steps, completion);
+                EXPECT_NEAR(bucketWalkStepSize(flow, 500, steps, completion), step, SMALL_DELTA);
+                sum += step;
+            }
+            EXPECT_NEAR(500.0, sum, SMALL_DELTA);
+        }
+    }
+}
+
+TEST(FlowTest, templatesMatchRuntimeNormalization)
+{
+    static constexpr double characteristics[] = {1, 2, 0, 4, 5, 3.5};
+    static constexpr auto flowTemplate = NaturalMouseMotion::FlowTemplate<6>::Normalize(characteristics);
+    Flow templateFlow(flowTemplate);
+    Flow runtimeFlow(FlowCharacteristicsContainer(std::begin(characteristics), std::end(characteristics)));
+
+    auto templateBuckets = templateFlow.getFlowCharacteristics();
+    auto runtimeBuckets = runtimeFlow.getFlowCharacteristics();
+    ASSERT_EQ(runtimeBuckets.size(), templateBuckets.size());
+    for (size_t i = 0; i < runtimeBuckets.size(); i++)
+    {
+        EXPECT_EQ(runtimeBuckets[i], templateBuckets[i]);
+    }
+    for (double completion = 0; completion <= 1.0; completion += 0.05)
+    {
+        EXPECT_EQ(runtimeFlow.getDistanceCovered(300, completion), templateFlow.getDistanceCovered(300, completion));
+    }
+}
+
+TEST(FlowTest, bucketViewAndZeroBucketsMatchCharacteristics)
+{
+    std::vector<Flow> flows = {
+        Flow(FlowTemplates::variatingFlow()),
+        Flow(FlowTemplates::interruptedFlow()),
+        Flow(FlowTemplates::stoppingFlow()),
+        Flow(FlowTemplates::constantSpeed()),
+        Flow({0, 0, 1, 0}),
+    };
+
+    for (auto &flow : flows)
+    {
+        auto characteristics = flow.getFlowCharacteristics();
+        auto buckets = flow.getBuckets();
+        ASSERT_EQ(characteristics.size(), buckets.size());
+        EXPECT_EQ(characteristics.size(), flow.getBucketCount());
+
+        size_t zeroBuckets = 0;
+        size_t i = 0;
+        for (auto bucket : buckets)
+        {
+            EXPECT_EQ(characteristics[i++], bucket);
+            if (std::abs(bucket - 0) < SMALL_DELTA)
+            {
+                zeroBuckets++;
+            }
+        }
+        EXPECT_EQ(zeroBuckets, flow.getZeroBucketCount());
+        EXPECT_NEAR(zeroBuckets / (double)buckets.size(), flow.getStoppedTimeFraction(), SMALL_DELTA);
+    }
+
+    EXPECT_EQ(3u, Flow({0, 0, 1, 0}).getZeroBucketCount());
+    EXPECT_EQ(0u, Flow(FlowTemplates::constantSpeed()).getZeroBucketCount());
+}
+
+TEST(FlowTest, templateFlowsAreOnlyMadeExplicitlyFromLastingTemplates)
+{
+    // the flow points into the template, so neither a silent conversion nor a temporary may make one
+    EXPECT_FALSE((std::is_convertible<const FlowTemplate<100> &, Flow>::value));
+    EXPECT_FALSE((std::is_constructible<Flow, FlowTemplate<100>>::value));
+    EXPECT_TRUE((std::is_constructible<Flow, const FlowTemplate<100> &>::value));
+}
@@ -3,12 +3,14 @@
 #include <cmath>
 #include "Flow.h"
 #include "FlowUtils.h"
+#include "FlowTemplates.h"
 #include "gtest/gtest.h"
 
 using NaturalMouseMotion::Flow;
 using NaturalMouseMotion::FlowCharacteristicsContainer;
 using NaturalMouseMotion::FlowModifierFunc;
 using NaturalMouseMotion::FlowUtils;
+using NaturalMouseMotion::FlowTemplates;
 
 static constexpr double SMALL_DELTA = 10e-6;
 
@@ -150,4 +152,87 @@ TEST(FlowUtilsTest, testReduceFlow_10to1) {
 
     double sum = std::accumulate(result.begin(), result.end(), 0.0);
     EXPECT_NEAR(sum, average(flow) * 1, SMALL_DELTA);
-}
\ No newline at end of file
+}
+
+// Stretch by building the full evenly spaced array and reducing it, the way FlowUtils used to do it.
+FlowCharacteristicsContainer stretchFlowByIntermediateArray(FlowCharacteristicsContainer flow, size_t targetLength)
+{
+    size_t tempLength = targetLength;
+    if (flow.size() != 1 && (tempLength - flow.size()) % (flow.size() - 1) != 0)
+    {
+        tempLength = (flow.size() - 1) * (tempLength - flow.size()) + 1;
+    }
+    FlowCharacteristicsContainer result(tempLength);
+    int insider = static_cast<int>(flow.size()) - 2;
+    int stepLength = (int)((tempLength - 2) / (double)(insider + 1)) + 1;
+    int countToNextStep = stepLength;
+    size_t fillValueIndex = 0;
+    for (size_t i = 0; i < tempLength; i++)
+    {
+        double fillValueBottom = flow[fillValueIndex];
+        double fillValueTop = fillValueIndex + 1 < flow.size() ? flow[fillValueIndex + 1] : flow[fillValueIndex];
+        double completion = (stepLength - countToNextStep) / (double)stepLength;
+        result[i] = fillValueBottom * (1 - completion) + fillValueTop * completion;
+        countToNextStep--;
+        if (countToNextStep == 0)
+        {
+            countToNextStep = stepLength;
+            fillValueIndex++;
+        }
+    }
+    if (tempLength != targetLength)
+    {
+        result = FlowUtils::reduceFlow(result, targetLength);
+    }
+    return result;
+}
+
+TEST(FlowUtilsTest, testStretchFlow_matchesIntermediateArray) {
+    std::vector<FlowCharacteristicsContainer> flows = {
+        {1, 2},
+        {1, 2, 3},
+        {1.1, 1.2, 1.3},
+        {5, 0, 3, 8, 1},
+        FlowTemplates::adjustingFlow(),
+        FlowTemplates::variatingFlow(),
+        FlowTemplates::stoppingFlow(),
+    };
+    for (auto &flow : flows)
+    {
+        for (size_t targetLength : {flow.size(), flow.size() + 1, flow.size() + 2, flow.size() * 2, flow.size() * 3 + 7, (size_t)1000})
+        {
+            size_t tempLength = (flow.size() - 1) * (targetLength - flow.size()) + 1;
+            if ((targetLength - flow.size()) % (flow.size() - 1) != 0 && tempLength <= targetLength)
+            {
+                continue; // the intermediate array would be shorter than the target, which the old implementation can't reduce
+            }
+            auto expected = stretchFlowByIntermediateArray(flow, targetLength);
+            auto result = FlowUtils::stretchFlow(flow, targetLength);
+            EXPECT_ARRAY_EQ(expected, result);
+        }
+    }
+}
+
+TEST(FlowUtilsTest, testStretchFlow_3to4) {
+    FlowCharacteristicsContainer flow = {1, 2, 3};
+    auto result = FlowUtils::stretchFlow(flow, 4);
+
+    double sum = std::accumulate(result.begin(), result.end(), 0.0);
+    EXPECT_NEAR(sum, average(flow) * 4, SMALL_DELTA);
+    EXPECT_NEAR(1.0, result[0], SMALL_DELTA);
+    EXPECT_NEAR(3.0, result[3], SMALL_DELTA);
+}
+
+TEST(FlowUtilsTest, testStretchFlow_intoCallerBuffer) {
+    FlowCharacteristicsContainer flow = {1, 2, 3};
+    FlowCharacteristicsContainer result(5);
+    FlowUtils::stretchFlow(flow.data(), flow.size(), result.data(), result.size(), [](double &d) { d *= 2.0; });
+    EXPECT_ARRAY_EQ(result, FlowCharacteristicsContainer({2.0, 3.0, 4.0, 5.0, 6.0}));
+}
+
+TEST(FlowUtilsTest, testStretchFlow_emptyModifier) {
+    FlowCharacteristicsContainer flow = {1, 2, 3};
+    FlowModifierFunc modifier;
+    auto result = FlowUtils::stretchFlow(flow, 5, modifier);
+    EXPECT_ARRAY_EQ(result, FlowCharacteristicsContainer({1.0, 1.5, 2.0, 2.5, 3}));
+}
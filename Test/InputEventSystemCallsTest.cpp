@@ -0,0 +1,169 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+#ifdef __linux__
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace NaturalMouseMotion;
+using DefaultProvider::InputEventSystemCalls;
+
+static std::vector<input_event> readEvents(int fd)
+{
+    std::vector<input_event> events;
+    input_event event;
+    while (read(fd, &event, sizeof(event)) == (ssize_t)sizeof(event))
+    {
+        events.push_back(event);
+    }
+    return events;
+}
+
+static void expectEvent(const input_event &event, unsigned short type, unsigned short code, int value)
+{
+    EXPECT_EQ(type, event.type);
+    EXPECT_EQ(code, event.code);
+    EXPECT_EQ(value, event.value);
+}
+
+struct Pipe
+{
+    int fds[2];
+
+    Pipe()
+    {
+        if (pipe(fds) != 0)
+        {
+            throw std::runtime_error("pipe");
+        }
+    }
+    ~Pipe()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    // Reads what has been written so far, without waiting for more
+    std::vector<input_event> drain()
+    {
+        close(fds[1]);
+        fds[1] = -1;
+        return readEvents(fds[0]);
+    }
+};
+
+TEST(InputEventSystemCallsTest, writesAbsolutePositionsOnFlush)
+{
+    Pipe events;
+    {
+        InputEventSystemCalls systemCalls(events.fds[1], {800, 500});
+        EXPECT_EQ(800, systemCalls.getScreenSize().Width);
+        systemCalls.setMousePosition(10, 20);
+        systemCalls.setMousePosition(11, 22);
+        // queued until playback waits for the next step
+        EXPECT_EQ(0u, systemCalls.getWrites());
+        EXPECT_EQ(11, systemCalls.getMousePosition().x);
+        EXPECT_EQ(22, systemCalls.getMousePosition().y);
+        systemCalls.sleepNanos(0);
+        EXPECT_EQ(1u, systemCalls.getWrites());
+        systemCalls.sleepNanos(0);
+        EXPECT_EQ(1u, systemCalls.getWrites());
+    }
+
+    auto written = events.drain();
+    ASSERT_EQ(6u, written.size());
+    expectEvent(written[0], EV_ABS, ABS_X, 10);
+    expectEvent(written[1], EV_ABS, ABS_Y, 20);
+    expectEvent(written[2], EV_SYN, SYN_REPORT, 0);
+    expectEvent(written[3], EV_ABS, ABS_X, 11);
+    expectEvent(written[4], EV_ABS, ABS_Y, 22);
+    expectEvent(written[5], EV_SYN, SYN_REPORT, 0);
+}
+
+TEST(InputEventSystemCallsTest, writesRelativeMotion)
+{
+    Pipe events;
+    {
+        // motion is relative to where the cursor was when the device was made
+        InputEventSystemCalls systemCalls(events.fds[1], {800, 500}, InputEventSystemCalls::Mode::Relative, {300, 200});
+        EXPECT_EQ(300, systemCalls.getMousePosition().x);
+        EXPECT_EQ(200, systemCalls.getMousePosition().y);
+        systemCalls.setMousePosition(310, 210);
+        systemCalls.setMousePosition(315, 210);
+        systemCalls.setMousePosition(312, 204);
+        // written when destroyed
+    }
+
+    auto written = events.drain();
+    ASSERT_EQ(8u, written.size());
+    expectEvent(written[0], EV_REL, REL_X, 10);
+    expectEvent(written[1], EV_REL, REL_Y, 10);
+    expectEvent(written[2], EV_SYN, SYN_REPORT, 0);
+    // the axis that didn't move is left out
+    expectEvent(written[3], EV_REL, REL_X, 5);
+    expectEvent(written[4], EV_SYN, SYN_REPORT, 0);
+    expectEvent(written[5], EV_REL, REL_X, -3);
+    expectEvent(written[6], EV_REL, REL_Y, -6);
+    expectEvent(written[7], EV_SYN, SYN_REPORT, 0);
+}
+
+TEST(InputEventSystemCallsTest, moveWritesEveryStepToAFile)
+{
+    FILE *file = std::tmpfile();
+    ASSERT_NE(nullptr, file);
+    auto systemCalls = std::make_shared<InputEventSystemCalls>(fileno(file), Dimension{800, 500});
+    systemCalls->spinNanos = 0;
+
+    auto nature = NewTestNature(systemCalls);
+    nature.getFlowWithTime = [](double) -> std::pair<const Flow *, time_type> {
+        static Flow flow{FlowTemplates::constantSpeed()};
+        return {&flow, 40};
+    };
+    nature.stats = std::make_shared<PlaybackStats>();
+
+    Move(nature, 400, 300);
+    systemCalls->flush();
+
+    std::rewind(file);
+    auto written = readEvents(fileno(file));
+    std::fclose(file);
+
+    ASSERT_FALSE(written.empty());
+    ASSERT_EQ(0u, written.size() % 3);
+    for (size_t i = 0; i < written.size(); i += 3)
+    {
+        EXPECT_EQ(EV_ABS, written[i].type);
+        EXPECT_EQ(ABS_X, written[i].code);
+        EXPECT_EQ(EV_ABS, written[i + 1].type);
+        EXPECT_EQ(ABS_Y, written[i + 1].code);
+        expectEvent(written[i + 2], EV_SYN, SYN_REPORT, 0);
+    }
+    EXPECT_EQ(nature.stats->emittedSteps, written.size() / 3);
+    EXPECT_EQ(400, written[written.size() - 3].value);
+    EXPECT_EQ(300, written[written.size() - 2].value);
+    // event times follow the steps
+    for (size_t i = 1; i < written.size(); i++)
+    {
+        EXPECT_GE(written[i].input_event_sec * 1000000 + written[i].input_event_usec,
+                  written[i - 1].input_event_sec * 1000000 + written[i - 1].input_event_usec);
+    }
+    EXPECT_LE(systemCalls->getWrites(), written.size() / 3);
+}
+
+TEST(InputEventSystemCallsTest, throwsWhenEventsCantBeWritten)
+{
+    int readOnly = open("/dev/null", O_RDONLY);
+    ASSERT_GE(readOnly, 0);
+    {
+        InputEventSystemCalls systemCalls(readOnly, {800, 500});
+        systemCalls.setMousePosition(1, 1);
+        EXPECT_THROW(systemCalls.flush(), std::runtime_error);
+        // the failed events were dropped
+        EXPECT_NO_THROW(systemCalls.flush());
+    }
+    close(readOnly);
+}
+
+#endif
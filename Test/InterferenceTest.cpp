@@ -0,0 +1,205 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include <vector>
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+// The user grabs the mouse and moves it to userPosition when the given step is set
+struct InterferingSystemCalls : public VirtualClockSystemCalls
+{
+    size_t interferAtStep;
+    Point<int> userPosition;
+    bool moved{false};
+    int foreignMotionQueries{0};
+    int watchers{0};
+    int watches{0};
+
+    InterferingSystemCalls(size_t interferAtStep, Point<int> userPosition) : interferAtStep(interferAtStep), userPosition(userPosition)
+    {
+    }
+
+    void setMousePosition(int x, int y) override
+    {
+        VirtualClockSystemCalls::setMousePosition(x, y);
+        if (positions.size() == interferAtStep)
+        {
+            positions.push_back({userPosition.x, userPosition.y, now});
+            moved = true;
+        }
+    }
+    bool takeForeignMotion() override
+    {
+        foreignMotionQueries++;
+        auto result = moved;
+        moved = false;
+        return result;
+    }
+    // Like the X11 listener, motion from before watching is dropped
+    void watchForeignMotion(bool watching) override
+    {
+        watchers += watching ? 1 : -1;
+        if (watching)
+        {
+            watches++;
+            moved = false;
+        }
+    }
+};
+
+static MotionNature NewInterferenceNature(std::shared_ptr<SystemCalls> systemCalls, InterferencePolicy policy)
+{
+    auto nature = NewTestNature(systemCalls);
+    SetSteadyMovements(nature, 250);
+    nature.stats = std::make_shared<PlaybackStats>();
+    nature.onInterference = policy;
+    return nature;
+}
+
+TEST(InterferenceTest, ignoredByDefault)
+{
+    auto systemCalls = std::make_shared<InterferingSystemCalls>(10, Point<int>{700, 50});
+    auto nature = NewInterferenceNature(systemCalls, InterferencePolicy::Ignore);
+    Move(nature, 400, 300);
+
+    // not even asked or watched, the movement played on and put the cursor on its endpoint
+    EXPECT_EQ(0, systemCalls->foreignMotionQueries);
+    EXPECT_EQ(0, systemCalls->watches);
+    EXPECT_EQ(0u, nature.stats->interferences);
+    EXPECT_EQ(32u, nature.stats->emittedSteps);
+    EXPECT_EQ(400, systemCalls->positions.back().x);
+    EXPECT_EQ(300, systemCalls->positions.back().y);
+}
+
+TEST(InterferenceTest, abortStopsAtTheDisturbedStep)
+{
+    auto systemCalls = std::make_shared<InterferingSystemCalls>(10, Point<int>{700, 50});
+    auto nature = NewInterferenceNature(systemCalls, InterferencePolicy::Abort);
+    Move(nature, 400, 300);
+
+    EXPECT_EQ(10, systemCalls->foreignMotionQueries);
+    EXPECT_EQ(1u, nature.stats->interferences);
+    EXPECT_EQ(1, systemCalls->watches);
+    EXPECT_EQ(0, systemCalls->watchers);
+    // the steps played before the user moved the mouse count
+    EXPECT_EQ(10u, nature.stats->emittedSteps);
+    EXPECT_GT(nature.stats->plannedNanos, 0);
+    EXPECT_LT(nature.stats->plannedNanos, 250 * NANOS_IN_MILLI);
+    // ten steps and the user's move, nothing after it
+    ASSERT_EQ(11u, systemCalls->positions.size());
+    EXPECT_EQ(700, systemCalls->positions.back().x);
+    EXPECT_EQ(50, systemCalls->positions.back().y);
+    // right away, not after the movement would have ended
+    EXPECT_LT(systemCalls->now, 100 * NANOS_IN_MILLI);
+}
+
+TEST(InterferenceTest, motionBeforeTheMoveIsNoInterference)
+{
+    auto systemCalls = std::make_shared<InterferingSystemCalls>(0, Point<int>{700, 50});
+    auto nature = NewInterferenceNature(systemCalls, InterferencePolicy::Abort);
+    // the user moved the mouse between moves
+    systemCalls->moved = true;
+    Move(nature, 400, 300);
+
+    EXPECT_EQ(0u, nature.stats->interferences);
+    EXPECT_EQ(32u, nature.stats->emittedSteps);
+    EXPECT_EQ(400, systemCalls->positions.back().x);
+    EXPECT_EQ(300, systemCalls->positions.back().y);
+    EXPECT_EQ(0, systemCalls->watchers);
+}
+
+TEST(InterferenceTest, replanContinuesFromWhereTheUserLeftTheCursor)
+{
+    auto systemCalls = std::make_shared<InterferingSystemCalls>(10, Point<int>{700, 50});
+    auto nature = NewInterferenceNature(systemCalls, InterferencePolicy::Replan);
+    Move(nature, 400, 300);
+
+    EXPECT_EQ(1u, nature.stats->interferences);
+    EXPECT_EQ(400, systemCalls->positions.back().x);
+    EXPECT_EQ(300, systemCalls->positions.back().y);
+    // the new movement starts next to the user's position instead of jumping back onto the old path
+    ASSERT_GT(systemCalls->positions.size(), 12u);
+    EXPECT_GT(systemCalls->positions[11].x, 400);
+    EXPECT_LT(systemCalls->positions[11].y, 100);
+    // a movement was cut short, so less than two full movements of time
+    EXPECT_LT(systemCalls->now, 500 * NANOS_IN_MILLI);
+}
+
+TEST(InterferenceTest, pipelineStopsLikeAbort)
+{
+    auto systemCalls = std::make_shared<InterferingSystemCalls>(10, Point<int>{700, 50});
+    auto nature = NewInterferenceNature(systemCalls, InterferencePolicy::Replan);
+    MovePipeline pipeline(nature);
+    pipeline.Move(std::vector<Point<int>>{{400, 300}, {100, 100}});
+
+    EXPECT_EQ(1u, nature.stats->interferences);
+    EXPECT_EQ(0, systemCalls->watchers);
+    ASSERT_EQ(11u, systemCalls->positions.size());
+    EXPECT_EQ(700, systemCalls->positions.back().x);
+
+    // the pipeline still works afterwards
+    systemCalls->interferAtStep = 0;
+    pipeline.Move(100, 100);
+    EXPECT_EQ(100, systemCalls->positions.back().x);
+    EXPECT_EQ(100, systemCalls->positions.back().y);
+}
+
+TEST(InterferenceTest, stepperReactsLikeMove)
+{
+    for (auto policy : {InterferencePolicy::Abort, InterferencePolicy::Replan})
+    {
+        auto expectedCalls = std::make_shared<InterferingSystemCalls>(10, Point<int>{700, 50});
+        auto expectedNature = NewInterferenceNature(expectedCalls, policy);
+        Move(expectedNature, 400, 300);
+
+        auto systemCalls = std::make_shared<InterferingSystemCalls>(10, Point<int>{700, 50});
+        auto nature = NewInterferenceNature(systemCalls, policy);
+        MotionStepper stepper(nature);
+        stepper.moveTo(400, 300);
+        for (auto deadline = stepper.advance(0); deadline != MotionStepper::FINISHED; deadline = stepper.advance(deadline))
+        {
+            systemCalls->now = deadline;
+        }
+
+        EXPECT_EQ(1u, nature.stats->interferences);
+        EXPECT_EQ(expectedNature.stats->emittedSteps, nature.stats->emittedSteps);
+        EXPECT_EQ(expectedNature.stats->emittedSteps, stepper.getEmittedSteps());
+        EXPECT_EQ(0, systemCalls->watchers);
+        ASSERT_EQ(expectedCalls->positions.size(), systemCalls->positions.size());
+        for (size_t i = 0; i < expectedCalls->positions.size(); i++)
+        {
+            EXPECT_EQ(expectedCalls->positions[i].x, systemCalls->positions[i].x);
+            EXPECT_EQ(expectedCalls->positions[i].y, systemCalls->positions[i].y);
+        }
+    }
+}
+
+#ifdef NATURAL_MOUSE_MOTION_COROUTINES
+TEST(InterferenceTest, coroutineReactsLikeMove)
+{
+    for (auto policy : {InterferencePolicy::Abort, InterferencePolicy::Replan})
+    {
+        auto expectedCalls = std::make_shared<InterferingSystemCalls>(10, Point<int>{700, 50});
+        auto expectedNature = NewInterferenceNature(expectedCalls, policy);
+        Move(expectedNature, 400, 300);
+
+        auto systemCalls = std::make_shared<InterferingSystemCalls>(10, Point<int>{700, 50});
+        auto nature = NewInterferenceNature(systemCalls, policy);
+        TimerExecutor executor(*systemCalls);
+        auto task = MoveCoroutine(executor, nature, 400, 300);
+        executor.spawn(task);
+        executor.run();
+        task.get();
+
+        EXPECT_EQ(1u, nature.stats->interferences);
+        EXPECT_EQ(expectedNature.stats->emittedSteps, nature.stats->emittedSteps);
+        EXPECT_EQ(0, systemCalls->watchers);
+        ASSERT_EQ(expectedCalls->positions.size(), systemCalls->positions.size());
+        for (size_t i = 0; i < expectedCalls->positions.size(); i++)
+        {
+            EXPECT_EQ(expectedCalls->positions[i].x, systemCalls->positions[i].x);
+            EXPECT_EQ(expectedCalls->positions[i].y, systemCalls->positions[i].y);
+        }
+    }
+}
+#endif
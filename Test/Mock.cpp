@@ -196,4 +196,65 @@ TEST_F(MockTest, cantMoveOutOfScreenToNegative_withOverShoots)
       EXPECT_TRUE(p.x >= 0 && p.y >= 0);
     }
     assertMousePosition(0, 0);
-}
\ No newline at end of file
+}
+TEST(MockStructs, testRandomStreamCopiesShareState)
+{
+    auto random = RandomStream{MockRandomProvider({0.1, 0.0, 0.4, 0.5})};
+    auto copy = random;
+    EXPECT_EQ(random(), 0.1);
+    EXPECT_EQ(copy(), 0.0);
+    EXPECT_EQ(random(), 0.4);
+    EXPECT_TRUE(static_cast<bool>(copy));
+    EXPECT_FALSE(static_cast<bool>(RandomStream{}));
+}
+
+using MockPolicyNature = BasicMotionNature<DefaultProvider::DefaultNoiseProvider, DefaultProvider::SinusoidalDeviationProvider, DefaultProvider::DefaultSpeedManager,
+                                           std::shared_ptr<MockOvershootManager>, MockSystemCalls *, RandomStream>;
+
+template <typename Nature>
+static void setPolicyTestDefaults(Nature &nature)
+{
+    nature.info_printer = nullptr;
+    nature.debug_printer = nullptr;
+    nature.observer = nullptr;
+    nature.timeToStepsDivider = DefaultProvider::TIME_TO_STEPS_DIVIDER;
+    nature.minSteps = DefaultProvider::MIN_STEPS;
+    nature.effectFadeSteps = DefaultProvider::EFFECT_FADE_STEPS;
+    nature.reactionTimeBaseMs = DefaultProvider::REACTION_TIME_BASE_MS;
+    nature.reactionTimeVariationMs = DefaultProvider::REACTION_TIME_VARIATION_MS;
+    nature.random = RandomStream{MockRandomProvider({0.3, 0.8, 0.01, 0.6, 0.45, 0.9, 0.2})};
+    nature.getDeviation = DefaultProvider::SinusoidalDeviationProvider();
+    nature.getNoise = DefaultProvider::DefaultNoiseProvider();
+    nature.getFlowWithTime = DefaultProvider::DefaultSpeedManager({Flow(FlowTemplates::variatingFlow()), Flow(FlowTemplates::jaggedFlow())}, nature.random);
+    auto overshootManager = std::make_shared<MockOvershootManager>(nature.random);
+    overshootManager->overshoots = 3;
+    nature.overshootManager = overshootManager;
+}
+
+TEST(MockStructs, policyNatureMovesLikeTypeErasedNature)
+{
+    MotionNature erased;
+    setPolicyTestDefaults(erased);
+    auto erasedCalls = std::make_shared<MockSystemCalls>(SCREEN_WIDTH, SCREEN_HEIGHT);
+    erased.systemCalls = erasedCalls;
+
+    MockPolicyNature policy;
+    setPolicyTestDefaults(policy);
+    MockSystemCalls policyCalls(SCREEN_WIDTH, SCREEN_HEIGHT);
+    policy.systemCalls = &policyCalls;
+
+    Move(erased, 600, 300);
+    Move(policy, 600, 300);
+
+    ASSERT_EQ(erasedCalls->mousePos.size(), policyCalls.mousePos.size());
+    EXPECT_TRUE(policyCalls.mousePos.size() > 5);
+    auto expected = erasedCalls->mousePos.begin();
+    for (auto &p : policyCalls.mousePos)
+    {
+        EXPECT_EQ(expected->x, p.x);
+        EXPECT_EQ(expected->y, p.y);
+        ++expected;
+    }
+    EXPECT_EQ(600, policyCalls.getMousePosition().x);
+    EXPECT_EQ(300, policyCalls.getMousePosition().y);
+}
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
 #include <list>
+#include <memory>
+#include <vector>
+#include "DefaultProvider.h"
 #include "MotionNature.h"
 
 using namespace NaturalMouseMotion;
@@ -54,3 +58,100 @@ struct MockSystemCalls: public SystemCalls
         return {lastPos.x, lastPos.y};
     }
 };
+
+// Time only passes when sleeping, so step times can be checked exactly
+struct VirtualClockSystemCalls : public SystemCalls
+{
+    struct TimedPosition
+    {
+        int x;
+        int y;
+        time_type nanos;
+    };
+
+    time_type now{0};
+    // every sleep wakes up this late
+    time_type wakeUpLatency{0};
+    // time it takes to set the mouse position
+    time_type setPositionNanos{0};
+    std::vector<TimedPosition> positions{};
+
+    time_type currentTimeMillis() override
+    {
+        return now / NANOS_IN_MILLI;
+    }
+    void sleep(time_type time) override
+    {
+        now += time * NANOS_IN_MILLI;
+    }
+    Dimension getScreenSize() override
+    {
+        return {800, 500};
+    }
+    void setMousePosition(int x, int y) override
+    {
+        positions.push_back({x, y, now});
+        now += setPositionNanos;
+    }
+    Point<int> getMousePosition() override
+    {
+        if (positions.empty())
+        {
+            return {0, 0};
+        }
+        return {positions.back().x, positions.back().y};
+    }
+    time_type currentTimeNanos() override
+    {
+        return now;
+    }
+    void sleepNanos(time_type nanos) override
+    {
+        now += nanos + wakeUpLatency;
+    }
+};
+
+// Up to the given number of overshoots, aimed by a random of their own
+inline void SetOvershoots(MotionNature &nature, int overshoots, RandomStream random)
+{
+    auto overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(random);
+    overshootManager->overshoots = overshoots;
+    nature.overshootManager = overshootManager;
+}
+
+// Straight movements at constant speed, each one taking movementMs
+inline void SetSteadyMovements(MotionNature &nature, time_type movementMs)
+{
+    nature.getDeviation = [](double, double) -> Point<double> { return {0, 0}; };
+    nature.getNoise = [](const RandomStream &, double, double) -> Point<double> { return {0, 0}; };
+    nature.getFlowWithTime = [movementMs](double) -> std::pair<const Flow *, time_type> {
+        static Flow flow{FlowTemplates::constantSpeed()};
+        return {&flow, movementMs};
+    };
+}
+
+// Quiet nature with the default step, reaction time, deviation and noise settings, where every movement takes
+// 100 ms plus half a millisecond per pixel with a variating flow and there are no overshoots.
+// Tests override what they depend on.
+inline MotionNature NewTestNature(std::shared_ptr<SystemCalls> systemCalls, RandomStream random = RandomStream{MockRandomProvider({0.5})})
+{
+    MotionNature nature;
+    nature.info_printer = nullptr;
+    nature.debug_printer = nullptr;
+    nature.observer = nullptr;
+    nature.timeToStepsDivider = DefaultProvider::TIME_TO_STEPS_DIVIDER;
+    nature.minSteps = DefaultProvider::MIN_STEPS;
+    nature.effectFadeSteps = DefaultProvider::EFFECT_FADE_STEPS;
+    nature.reactionTimeBaseMs = DefaultProvider::REACTION_TIME_BASE_MS;
+    nature.reactionTimeVariationMs = DefaultProvider::REACTION_TIME_VARIATION_MS;
+    nature.random = random;
+    nature.getDeviation = GetDeviationFunc{DefaultProvider::SinusoidalDeviationProvider()};
+    nature.getNoise = GetNoiseFunc{DefaultProvider::DefaultNoiseProvider()};
+    nature.getFlowWithTime = [](double distance) -> std::pair<const Flow *, time_type> {
+        static Flow flow{FlowTemplates::variatingFlow()};
+        return {&flow, 100 + (time_type)distance / 2};
+    };
+    SetOvershoots(nature, 0, nature.random);
+    nature.systemCalls = systemCalls;
+    return nature;
+}
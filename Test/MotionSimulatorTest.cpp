@@ -0,0 +1,208 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include <stdexcept>
+#include <vector>
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+// Sink of a simulated pointer, keeps only what the tests look at
+struct CountingSystemCalls : public SystemCalls
+{
+    Point<int> position{0, 0};
+    uint64_t positionsSet{0};
+
+    time_type currentTimeMillis() override
+    {
+        return 0;
+    }
+    void sleep(time_type /* time */) override
+    {
+    }
+    Dimension getScreenSize() override
+    {
+        return {1920, 1080};
+    }
+    void setMousePosition(int x, int y) override
+    {
+        position = {x, y};
+        positionsSet++;
+    }
+    Point<int> getMousePosition() override
+    {
+        return position;
+    }
+};
+
+static MotionNature NewSimulatedNature(std::shared_ptr<SystemCalls> systemCalls, RandomStream random)
+{
+    auto nature = NewTestNature(systemCalls, random);
+    SetOvershoots(nature, 2, RandomStream{MockRandomProvider({0.9, 0.2, 0.7})});
+    return nature;
+}
+
+TEST(MotionStepperTest, movesLikeMove)
+{
+    std::vector<Point<int>> targets = {{400, 300}, {100, 50}, {900, 20}};
+
+    auto expectedCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto expectedNature = NewSimulatedNature(expectedCalls, RandomStream{MockRandomProvider({0.3, 0.8, 0.5, 0.1, 0.65})});
+    for (auto &target : targets)
+    {
+        Move(expectedNature, target.x, target.y);
+    }
+
+    // the stepper's sink is told the time, so its positions carry the time they were emitted at
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewSimulatedNature(systemCalls, RandomStream{MockRandomProvider({0.3, 0.8, 0.5, 0.1, 0.65})});
+    MotionStepper stepper(nature);
+    EXPECT_TRUE(stepper.finished());
+    for (auto &target : targets)
+    {
+        stepper.moveTo(target.x, target.y);
+        for (auto deadline = stepper.advance(systemCalls->now); deadline != MotionStepper::FINISHED; deadline = stepper.advance(systemCalls->now))
+        {
+            EXPECT_GT(deadline, systemCalls->now);
+            systemCalls->now = deadline;
+        }
+        EXPECT_TRUE(stepper.finished());
+    }
+
+    ASSERT_EQ(expectedCalls->positions.size(), systemCalls->positions.size());
+    for (size_t i = 0; i < expectedCalls->positions.size(); i++)
+    {
+        EXPECT_EQ(expectedCalls->positions[i].x, systemCalls->positions[i].x);
+        EXPECT_EQ(expectedCalls->positions[i].y, systemCalls->positions[i].y);
+        EXPECT_EQ(expectedCalls->positions[i].nanos, systemCalls->positions[i].nanos);
+    }
+    EXPECT_EQ(expectedCalls->now, systemCalls->now);
+    EXPECT_EQ(systemCalls->positions.size(), stepper.getEmittedSteps());
+}
+
+TEST(MotionSimulatorTest, movesThousandsOfPointers)
+{
+    const int pointerCount = 2000;
+    std::vector<std::shared_ptr<CountingSystemCalls>> sinks;
+    std::vector<MotionNature> natures;
+    natures.reserve(pointerCount);
+    MotionSimulator::Options options;
+    options.threads = 4;
+    MotionSimulator simulator(options);
+    for (int i = 0; i < pointerCount; i++)
+    {
+        sinks.push_back(std::make_shared<CountingSystemCalls>());
+        natures.push_back(NewSimulatedNature(sinks.back(), RandomStream{DefaultProvider::FastRandomProvider(i)}));
+        simulator.addPointer(natures.back(), {{(i * 37) % 1920, (i * 53) % 1080}, {(i * 71) % 1920, (i * 13) % 1080}});
+    }
+    EXPECT_EQ((size_t)pointerCount, simulator.getPointerCount());
+
+    auto report = simulator.run();
+
+    uint64_t positionsSet = 0;
+    for (int i = 0; i < pointerCount; i++)
+    {
+        EXPECT_EQ((i * 71) % 1920, sinks[i]->position.x);
+        EXPECT_EQ((i * 13) % 1080, sinks[i]->position.y);
+        positionsSet += sinks[i]->positionsSet;
+    }
+    EXPECT_EQ((uint64_t)pointerCount, report.pointers);
+    EXPECT_EQ((uint64_t)pointerCount * 2, report.moves);
+    EXPECT_EQ(positionsSet, report.steps);
+    // pointers moved at the same time, not one after another
+    EXPECT_GT(report.simulatedNanos, 100 * NANOS_IN_MILLI);
+    EXPECT_LT(report.simulatedNanos, 60000 * NANOS_IN_MILLI);
+    EXPECT_GT(report.stepsPerSecond(), 0);
+    EXPECT_GT(report.speedup(), 0);
+}
+
+TEST(MotionSimulatorTest, runsInRealTime)
+{
+    auto sink = std::make_shared<CountingSystemCalls>();
+    auto nature = NewSimulatedNature(sink, RandomStream{MockRandomProvider({0.5})});
+    MotionSimulator::Options options;
+    options.realTime = true;
+    MotionSimulator simulator(options);
+    simulator.addPointer(nature, {{200, 100}});
+
+    auto report = simulator.run();
+    EXPECT_EQ(200, sink->position.x);
+    EXPECT_EQ(100, sink->position.y);
+    EXPECT_GE(report.wallNanos, report.simulatedNanos - 2 * NANOS_IN_MILLI);
+    EXPECT_GT(report.simulatedNanos, 100 * NANOS_IN_MILLI);
+}
+
+TEST(MotionSimulatorTest, rethrowsFailures)
+{
+    auto sink = std::make_shared<CountingSystemCalls>();
+    auto nature = NewSimulatedNature(sink, RandomStream{MockRandomProvider({0.5})});
+    nature.getFlowWithTime = [](double) -> std::pair<const Flow *, time_type> {
+        throw std::runtime_error("no flow");
+    };
+    auto otherSink = std::make_shared<CountingSystemCalls>();
+    auto otherNature = NewSimulatedNature(otherSink, RandomStream{MockRandomProvider({0.5})});
+    MotionSimulator::Options options;
+    options.threads = 2;
+    MotionSimulator simulator(options);
+    simulator.addPointer(nature, {{200, 100}});
+    simulator.addPointer(otherNature, {{300, 100}});
+
+    EXPECT_THROW(simulator.run(), std::runtime_error);
+    // the other thread still finished its pointers
+    EXPECT_EQ(300, otherSink->position.x);
+}
+
+TEST(MotionSimulatorTest, runsAgainFromTheFirstTargetAfterAFailure)
+{
+    struct FailingSystemCalls : public CountingSystemCalls
+    {
+        std::vector<Point<int>> positions{};
+        // setMousePosition throws once, when it is called for this time
+        uint64_t failAt{0};
+
+        void setMousePosition(int x, int y) override
+        {
+            if (positionsSet + 1 == failAt)
+            {
+                failAt = 0;
+                throw std::runtime_error("can't move");
+            }
+            CountingSystemCalls::setMousePosition(x, y);
+            positions.push_back({x, y});
+        }
+    };
+    std::vector<Point<int>> targets{{200, 100}, {900, 700}};
+
+    auto reference = std::make_shared<FailingSystemCalls>();
+    auto referenceNature = NewSimulatedNature(reference, RandomStream{MockRandomProvider({0.5})});
+    MotionSimulator referenceSimulator;
+    referenceSimulator.addPointer(referenceNature, targets);
+    referenceSimulator.run();
+    size_t firstMove = 0;
+    while (reference->positions[firstMove].x != 200 || reference->positions[firstMove].y != 100)
+    {
+        firstMove++;
+    }
+
+    auto sink = std::make_shared<FailingSystemCalls>();
+    auto nature = NewSimulatedNature(sink, RandomStream{MockRandomProvider({0.5})});
+    MotionSimulator simulator;
+    simulator.addPointer(nature, targets);
+    // halfway to the second target
+    sink->failAt = firstMove + 1 + (reference->positions.size() - firstMove) / 2;
+    EXPECT_THROW(simulator.run(), std::runtime_error);
+    ASSERT_NE(900, sink->position.x);
+
+    auto failed = sink->positions.size();
+    auto report = simulator.run();
+    EXPECT_EQ(2u, report.moves);
+    // the first target is reached again before the second
+    size_t reached = failed;
+    while (reached < sink->positions.size() && (sink->positions[reached].x != 200 || sink->positions[reached].y != 100))
+    {
+        EXPECT_FALSE(sink->positions[reached].x == 900 && sink->positions[reached].y == 700);
+        reached++;
+    }
+    EXPECT_LT(reached, sink->positions.size());
+    EXPECT_EQ(900, sink->position.x);
+    EXPECT_EQ(700, sink->position.y);
+}
@@ -0,0 +1,222 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+// Real time, so moves take as long on the executor as they would on screen
+struct SteadyClockSystemCalls : public SystemCalls
+{
+    std::mutex mutex{};
+    std::vector<Point<int>> positions{};
+
+    time_type currentTimeMillis() override
+    {
+        return DefaultProvider::SteadyClock::Nanos() / NANOS_IN_MILLI;
+    }
+    void sleep(time_type time) override
+    {
+        DefaultProvider::SteadyClock::SleepNanos(time * NANOS_IN_MILLI);
+    }
+    Dimension getScreenSize() override
+    {
+        return {800, 500};
+    }
+    void setMousePosition(int x, int y) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        positions.push_back({x, y});
+    }
+    Point<int> getMousePosition() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return positions.empty() ? Point<int>{0, 0} : positions.back();
+    }
+    time_type currentTimeNanos() override
+    {
+        return DefaultProvider::SteadyClock::Nanos();
+    }
+    void sleepUntilNanos(time_type deadline) override
+    {
+        DefaultProvider::SteadyClock::SleepUntilNanos(deadline);
+    }
+};
+
+static MotionNature NewAsyncNature(std::shared_ptr<SystemCalls> systemCalls, time_type movementMs)
+{
+    auto nature = NewTestNature(systemCalls);
+    SetSteadyMovements(nature, movementMs);
+    return nature;
+}
+
+static void waitForProgress(const MoveHandle &handle, int movement, int step)
+{
+    while (!handle.done())
+    {
+        auto progress = handle.progress();
+        if (progress.movement > movement || (progress.movement == movement && progress.step >= step))
+        {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+TEST(MoveAsyncTest, movesInTheBackground)
+{
+    auto systemCalls = std::make_shared<SteadyClockSystemCalls>();
+    auto nature = NewAsyncNature(systemCalls, 100);
+    PlaybackExecutor executor;
+
+    auto handle = MoveAsync(executor, nature, 400, 300);
+    ASSERT_TRUE(handle.valid());
+    handle.wait();
+
+    EXPECT_TRUE(handle.done());
+    EXPECT_FALSE(handle.isCancelled());
+    auto progress = handle.progress();
+    EXPECT_EQ(1, progress.movement);
+    EXPECT_EQ(1, progress.movements);
+    EXPECT_EQ(progress.steps, progress.step);
+    EXPECT_EQ((size_t)progress.steps, systemCalls->positions.size());
+    EXPECT_EQ(400, systemCalls->positions.back().x);
+    EXPECT_EQ(300, systemCalls->positions.back().y);
+}
+
+TEST(MoveAsyncTest, cancelStopsWithinOneStep)
+{
+    auto systemCalls = std::make_shared<SteadyClockSystemCalls>();
+    // 500 steps of 10 ms
+    auto nature = NewAsyncNature(systemCalls, 5000);
+    PlaybackExecutor executor;
+
+    auto handle = MoveAsync(executor, nature, 400, 300);
+    waitForProgress(handle, 1, 5);
+    handle.cancel();
+    // one step and plenty of room for a loaded machine, the whole move would take seconds
+    ASSERT_TRUE(handle.waitFor(500));
+    handle.wait();
+
+    auto progress = handle.progress();
+    EXPECT_TRUE(handle.isCancelled());
+    EXPECT_EQ(500, progress.steps);
+    EXPECT_GE(progress.step, 5);
+    EXPECT_LT(progress.step, progress.steps);
+    EXPECT_EQ((size_t)progress.step, systemCalls->positions.size());
+    EXPECT_NE(400, systemCalls->positions.back().x);
+}
+
+TEST(MoveAsyncTest, cancelInterruptsReactionTime)
+{
+    auto systemCalls = std::make_shared<SteadyClockSystemCalls>();
+    auto nature = NewAsyncNature(systemCalls, 50);
+    nature.reactionTimeBaseMs = 5000;
+    // aims off the target, so the move needs a correction after the first movement
+    auto overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(RandomStream{MockRandomProvider({0.9})});
+    overshootManager->overshoots = 1;
+    nature.overshootManager = overshootManager;
+    PlaybackExecutor executor;
+
+    auto handle = MoveAsync(executor, nature, 400, 300);
+    // the first movement has played, the overshoot correction waits for the reaction time
+    for (auto progress = handle.progress(); !(progress.movement == 1 && progress.steps > 0 && progress.step == progress.steps); progress = handle.progress())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(2, handle.progress().movements);
+    handle.cancel();
+    ASSERT_TRUE(handle.waitFor(500));
+
+    auto progress = handle.progress();
+    EXPECT_EQ(1, progress.movement);
+    EXPECT_EQ(progress.steps, progress.step);
+}
+
+TEST(MoveAsyncTest, movesRunInOrderAndCancelledOnesDontStart)
+{
+    auto systemCalls = std::make_shared<SteadyClockSystemCalls>();
+    auto nature = NewAsyncNature(systemCalls, 5000);
+    auto secondNature = NewAsyncNature(systemCalls, 50);
+    auto thirdNature = NewAsyncNature(systemCalls, 50);
+    PlaybackExecutor executor;
+
+    auto first = MoveAsync(executor, nature, 400, 300);
+    auto second = MoveAsync(executor, secondNature, 100, 100);
+    auto third = MoveAsync(executor, thirdNature, 200, 100);
+    second.cancel();
+    waitForProgress(first, 1, 1);
+    first.cancel();
+    third.wait();
+
+    EXPECT_TRUE(first.done());
+    EXPECT_TRUE(second.done());
+    EXPECT_EQ(0, second.progress().movement);
+    EXPECT_EQ(0, second.progress().step);
+    EXPECT_EQ(1, third.progress().movement);
+    EXPECT_EQ(200, systemCalls->positions.back().x);
+    EXPECT_EQ(100, systemCalls->positions.back().y);
+}
+
+TEST(MoveAsyncTest, waitRethrowsFailures)
+{
+    auto systemCalls = std::make_shared<SteadyClockSystemCalls>();
+    auto nature = NewAsyncNature(systemCalls, 100);
+    nature.getFlowWithTime = [](double) -> std::pair<const Flow *, time_type> {
+        throw std::runtime_error("no flow");
+    };
+
+    auto handle = MoveAsync(nature, 400, 300);
+    EXPECT_THROW(handle.wait(), std::runtime_error);
+    EXPECT_TRUE(handle.done());
+}
+
+TEST(MoveAsyncTest, handlesWithoutMoveDoNothing)
+{
+    MoveHandle handle;
+    EXPECT_FALSE(handle.valid());
+    handle.wait();
+    EXPECT_TRUE(handle.waitFor(0));
+    EXPECT_TRUE(handle.done());
+    handle.cancel();
+    EXPECT_FALSE(handle.isCancelled());
+    EXPECT_EQ(0, handle.progress().steps);
+
+    auto systemCalls = std::make_shared<SteadyClockSystemCalls>();
+    auto nature = NewAsyncNature(systemCalls, 10);
+    PlaybackExecutor executor;
+    auto moved = MoveAsync(executor, nature, 400, 300);
+    auto kept = std::move(moved);
+    kept.wait();
+    moved.wait();
+    EXPECT_TRUE(moved.done());
+    moved.cancel();
+    EXPECT_FALSE(moved.isCancelled());
+    EXPECT_EQ(0, moved.progress().movement);
+}
+
+TEST(MoveAsyncTest, destroyingTheExecutorCancelsItsMoves)
+{
+    auto systemCalls = std::make_shared<SteadyClockSystemCalls>();
+    auto nature = NewAsyncNature(systemCalls, 5000);
+    auto queuedNature = NewAsyncNature(systemCalls, 5000);
+    MoveHandle playing;
+    MoveHandle queued;
+    auto start = std::chrono::steady_clock::now();
+    {
+        PlaybackExecutor executor;
+        playing = MoveAsync(executor, nature, 400, 300);
+        queued = MoveAsync(executor, queuedNature, 100, 100);
+        waitForProgress(playing, 1, 1);
+    }
+    // both moves together would take ten seconds
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_TRUE(playing.isCancelled());
+    EXPECT_TRUE(queued.isCancelled());
+    playing.wait();
+    queued.wait();
+    EXPECT_LT(playing.progress().step, playing.progress().steps);
+    EXPECT_EQ(0, queued.progress().movement);
+}
@@ -0,0 +1,191 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+// Only built when configured with -DCMAKE_CXX_STANDARD=20
+#ifdef NATURAL_MOUSE_MOTION_COROUTINES
+
+#include <stdexcept>
+#include <vector>
+
+using namespace NaturalMouseMotion;
+
+// A virtual pointer, timestamped by a clock shared with the other pointers
+struct VirtualPointerSystemCalls : public SystemCalls
+{
+    VirtualClockSystemCalls &clock;
+    std::vector<VirtualClockSystemCalls::TimedPosition> positions{};
+
+    explicit VirtualPointerSystemCalls(VirtualClockSystemCalls &clock) : clock(clock)
+    {
+    }
+
+    time_type currentTimeMillis() override
+    {
+        return clock.currentTimeMillis();
+    }
+    void sleep(time_type time) override
+    {
+        clock.sleep(time);
+    }
+    Dimension getScreenSize() override
+    {
+        return clock.getScreenSize();
+    }
+    void setMousePosition(int x, int y) override
+    {
+        positions.push_back({x, y, clock.now});
+    }
+    Point<int> getMousePosition() override
+    {
+        if (positions.empty())
+        {
+            return {0, 0};
+        }
+        return {positions.back().x, positions.back().y};
+    }
+    time_type currentTimeNanos() override
+    {
+        return clock.now;
+    }
+};
+
+static MotionNature NewCoroutineNature(std::shared_ptr<SystemCalls> systemCalls, double seed)
+{
+    auto nature = NewTestNature(systemCalls, RandomStream{MockRandomProvider({seed, 0.8, 0.5, 0.1, 0.65})});
+    SetOvershoots(nature, 2, RandomStream{MockRandomProvider({0.9, 0.2, 0.7})});
+    return nature;
+}
+
+static MoveTask MoveThrough(TimerExecutor &executor, MotionNature &nature, std::vector<Point<int>> targets)
+{
+    for (auto &target : targets)
+    {
+        co_await MoveCoroutine(executor, nature, target.x, target.y);
+    }
+}
+
+template <typename Positions>
+static void expectSamePositions(const std::vector<VirtualClockSystemCalls::TimedPosition> &expected, const Positions &actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(expected[i].x, actual[i].x);
+        EXPECT_EQ(expected[i].y, actual[i].y);
+        EXPECT_EQ(expected[i].nanos, actual[i].nanos);
+    }
+}
+
+TEST(MoveCoroutineTest, movesLikeBlockingMove)
+{
+    auto expectedCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto expectedNature = NewCoroutineNature(expectedCalls, 0.3);
+    Move(expectedNature, 400, 300);
+
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewCoroutineNature(systemCalls, 0.3);
+    TimerExecutor executor(*systemCalls);
+    auto task = MoveCoroutine(executor, nature, 400, 300);
+    EXPECT_FALSE(task.done());
+    executor.spawn(task);
+    executor.run();
+
+    ASSERT_TRUE(task.done());
+    task.get();
+    EXPECT_EQ(0u, executor.waiting());
+    EXPECT_EQ(400, systemCalls->positions.back().x);
+    EXPECT_EQ(300, systemCalls->positions.back().y);
+    expectSamePositions(expectedCalls->positions, systemCalls->positions);
+    EXPECT_EQ(expectedCalls->now, systemCalls->now);
+}
+
+TEST(MoveCoroutineTest, oneThreadDrivesManyPointers)
+{
+    std::vector<std::vector<Point<int>>> paths = {
+        {{400, 300}, {100, 50}},
+        {{700, 20}, {20, 480}, {300, 300}},
+        {{50, 450}},
+        {{799, 499}, {0, 0}},
+    };
+    std::vector<double> seeds = {0.3, 0.45, 0.6, 0.75};
+
+    VirtualClockSystemCalls clock;
+    TimerExecutor executor(clock);
+    std::vector<std::shared_ptr<VirtualPointerSystemCalls>> pointers;
+    std::vector<MotionNature> natures;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        pointers.push_back(std::make_shared<VirtualPointerSystemCalls>(clock));
+        natures.push_back(NewCoroutineNature(pointers.back(), seeds[i]));
+    }
+    std::vector<MoveTask> tasks;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        tasks.push_back(MoveThrough(executor, natures[i], paths[i]));
+        executor.spawn(tasks.back());
+    }
+    executor.run();
+
+    // every pointer moved as if it had a thread and a clock of its own, all at the same time
+    time_type longest = 0;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        ASSERT_TRUE(tasks[i].done());
+        auto alone = std::make_shared<VirtualClockSystemCalls>();
+        auto nature = NewCoroutineNature(alone, seeds[i]);
+        for (auto &target : paths[i])
+        {
+            Move(nature, target.x, target.y);
+        }
+        expectSamePositions(alone->positions, pointers[i]->positions);
+        EXPECT_EQ(paths[i].back().x, pointers[i]->positions.back().x);
+        EXPECT_EQ(paths[i].back().y, pointers[i]->positions.back().y);
+        longest = std::max(longest, alone->now);
+    }
+    EXPECT_EQ(longest, clock.now);
+}
+
+TEST(MoveCoroutineTest, controlCancelsAndShowsProgress)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewCoroutineNature(systemCalls, 0.3);
+    MoveControl control;
+    nature.observer = [&systemCalls, &control](int, int) {
+        if (systemCalls->positions.size() == 5)
+        {
+            control.cancel();
+        }
+    };
+    TimerExecutor executor(*systemCalls);
+    auto task = MoveCoroutine(executor, nature, 400, 300, &control);
+    executor.spawn(task);
+    executor.run();
+    task.get();
+
+    // stopped before the step after the one that cancelled
+    EXPECT_EQ(5u, systemCalls->positions.size());
+    auto progress = control.progress();
+    EXPECT_EQ(1, progress.movement);
+    EXPECT_EQ(2, progress.movements);
+    EXPECT_EQ(5, progress.step);
+    EXPECT_GT(progress.steps, 5);
+}
+
+TEST(MoveCoroutineTest, failuresAreRethrownByGet)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewCoroutineNature(systemCalls, 0.3);
+    nature.getFlowWithTime = [](double) -> std::pair<const Flow *, time_type> {
+        throw std::runtime_error("no flow");
+    };
+    TimerExecutor executor(*systemCalls);
+    auto task = MoveThrough(executor, nature, {{400, 300}});
+    executor.spawn(task);
+    executor.run();
+
+    ASSERT_TRUE(task.done());
+    EXPECT_THROW(task.get(), std::runtime_error);
+}
+
+#endif
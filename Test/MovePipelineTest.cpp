@@ -0,0 +1,165 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+static MotionNature NewPipelineNature(std::shared_ptr<SystemCalls> systemCalls)
+{
+    auto nature = NewTestNature(systemCalls, RandomStream{MockRandomProvider({0.3, 0.8, 0.5, 0.1, 0.65})});
+    // aims off the target, so moves need corrections
+    SetOvershoots(nature, 2, RandomStream{MockRandomProvider({0.9, 0.2, 0.7})});
+    return nature;
+}
+
+static void expectSamePositions(const VirtualClockSystemCalls &expected, const VirtualClockSystemCalls &actual)
+{
+    ASSERT_EQ(expected.positions.size(), actual.positions.size());
+    for (size_t i = 0; i < expected.positions.size(); i++)
+    {
+        EXPECT_EQ(expected.positions[i].x, actual.positions[i].x);
+        EXPECT_EQ(expected.positions[i].y, actual.positions[i].y);
+        EXPECT_EQ(expected.positions[i].nanos, actual.positions[i].nanos);
+    }
+}
+
+TEST(SpscRingTest, handsSlotsOverInOrder)
+{
+    SpscRing<int, 4> ring;
+    EXPECT_EQ(nullptr, ring.front());
+    for (int i = 0; i < 4; i++)
+    {
+        auto slot = ring.claim();
+        ASSERT_NE(nullptr, slot);
+        *slot = i;
+        ring.publish();
+    }
+    EXPECT_EQ(nullptr, ring.claim());
+    EXPECT_EQ(0, *ring.front());
+    ring.release();
+    ASSERT_NE(nullptr, ring.claim());
+
+    const int count = 100000;
+    std::thread producer([&ring]() {
+        for (int i = 4; i < count; i++)
+        {
+            int *slot;
+            while ((slot = ring.claim()) == nullptr)
+            {
+                std::this_thread::yield();
+            }
+            *slot = i;
+            ring.publish();
+        }
+    });
+    for (int expected = 1; expected < count; expected++)
+    {
+        int *slot;
+        while ((slot = ring.front()) == nullptr)
+        {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(expected, *slot);
+        ring.release();
+    }
+    producer.join();
+    EXPECT_EQ(nullptr, ring.front());
+}
+
+TEST(MovePipelineTest, movesLikeMove)
+{
+    auto expectedCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto expectedNature = NewPipelineNature(expectedCalls);
+    MoveImp::Move(expectedNature, 400, 300);
+
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewPipelineNature(systemCalls);
+    MovePipeline pipeline(nature);
+    pipeline.Move(400, 300);
+
+    EXPECT_EQ(400, systemCalls->positions.back().x);
+    EXPECT_EQ(300, systemCalls->positions.back().y);
+    expectSamePositions(*expectedCalls, *systemCalls);
+}
+
+TEST(MovePipelineTest, queuedTargetsMoveLikeConsecutiveMoves)
+{
+    std::vector<Point<int>> targets = {{400, 300}, {100, 50}, {900, 20}, {120, 480}};
+
+    auto expectedCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto expectedNature = NewPipelineNature(expectedCalls);
+    for (auto &target : targets)
+    {
+        MoveImp::Move(expectedNature, target.x, target.y);
+    }
+
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewPipelineNature(systemCalls);
+    MovePipeline pipeline(nature);
+    pipeline.Move(targets);
+
+    // clamped to the screen like Move does
+    EXPECT_EQ(120, systemCalls->positions.back().x);
+    EXPECT_EQ(480, systemCalls->positions.back().y);
+    expectSamePositions(*expectedCalls, *systemCalls);
+}
+
+TEST(MovePipelineTest, planningFailureIsRethrownAndPipelineKeepsWorking)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewPipelineNature(systemCalls);
+    auto getFlowWithTime = nature.getFlowWithTime;
+    int calls = 0;
+    int failingCall = 0;
+    nature.getFlowWithTime = [&calls, &failingCall, getFlowWithTime](double distance) -> std::pair<const Flow *, time_type> {
+        if (++calls == failingCall)
+        {
+            throw std::runtime_error("no flow");
+        }
+        return getFlowWithTime(distance);
+    };
+    {
+        auto countingNature = NewPipelineNature(std::make_shared<VirtualClockSystemCalls>());
+        countingNature.getFlowWithTime = nature.getFlowWithTime;
+        MoveImp::Move(countingNature, 400, 300);
+        failingCall = calls + 1;
+        calls = 0;
+    }
+    MovePipeline pipeline(nature);
+
+    // the first target plays, planning the second one fails
+    std::vector<Point<int>> targets = {{400, 300}, {100, 50}};
+    EXPECT_THROW(pipeline.Move(targets), std::runtime_error);
+    EXPECT_EQ(400, systemCalls->positions.back().x);
+    EXPECT_EQ(300, systemCalls->positions.back().y);
+
+    pipeline.Move(100, 50);
+    EXPECT_EQ(100, systemCalls->positions.back().x);
+    EXPECT_EQ(50, systemCalls->positions.back().y);
+}
+
+TEST(MovePipelineTest, playbackFailureStopsThePlanner)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewPipelineNature(systemCalls);
+    int steps = 0;
+    nature.observer = [&steps](int, int) {
+        if (++steps == 3)
+        {
+            throw std::runtime_error("observer");
+        }
+    };
+    MovePipeline pipeline(nature);
+
+    std::vector<Point<int>> targets = {{400, 300}, {100, 50}, {700, 20}, {20, 400}, {300, 300}, {50, 50}};
+    EXPECT_THROW(pipeline.Move(targets), std::runtime_error);
+    EXPECT_EQ(3u, systemCalls->positions.size());
+
+    nature.observer = nullptr;
+    pipeline.Move(600, 200);
+    EXPECT_EQ(600, systemCalls->positions.back().x);
+    EXPECT_EQ(200, systemCalls->positions.back().y);
+}
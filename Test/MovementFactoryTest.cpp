@@ -218,3 +218,33 @@ TEST(MovementFactoryTest, testZeroOffsetOvershootsRemovedFromEndIfAllZero)
     EXPECT_NEAR(50, movements.front().yDistance, SMALL_DELTA);
     EXPECT_ARRAY_EQ(SingleElementArray_100, movements.front().flow->getFlowCharacteristics());
 }
+
+TEST(MovementListTest, keepsOrderWhenMovedToHeap)
+{
+    MovementList movements;
+    for (int i = 0; i < (int)MovementList::INLINE_CAPACITY + 5; i++)
+    {
+        movements.emplace_back(i, i, 0, 0, 0, 0, nullptr);
+    }
+    ASSERT_EQ(MovementList::INLINE_CAPACITY + 5, movements.size());
+    movements.pop_back();
+    movements.emplace_back(-1, -1, 0, 0, 0, 0, nullptr);
+    movements.pop_front();
+
+    EXPECT_EQ(1, movements.front().destX);
+    EXPECT_EQ(-1, movements.back().destX);
+    int expected = 1;
+    for (auto &m : movements)
+    {
+        if (&m != &movements.back())
+        {
+            EXPECT_EQ(expected++, m.destX);
+        }
+    }
+    EXPECT_EQ((int)MovementList::INLINE_CAPACITY + 4, expected);
+
+    movements.clear();
+    EXPECT_TRUE(movements.empty());
+    movements.emplace_back(5, 6, 0, 0, 0, 0, nullptr);
+    EXPECT_EQ(6, movements.front().destY);
+}
@@ -0,0 +1,186 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include <vector>
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+static MotionNature NewPacingNature(std::shared_ptr<SystemCalls> systemCalls, time_type movementMs)
+{
+    auto nature = NewTestNature(systemCalls);
+    SetSteadyMovements(nature, movementMs);
+    return nature;
+}
+
+TEST(PacingTest, stepsAddUpToMovementTime)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    // 250 ms is 32 steps of 7.8125 ms, whole milliseconds would lose 26 ms
+    auto nature = NewPacingNature(systemCalls, 250);
+    Move(nature, 400, 300);
+
+    auto &positions = systemCalls->positions;
+    ASSERT_EQ(32u, positions.size());
+    EXPECT_EQ(400, positions.back().x);
+    EXPECT_EQ(300, positions.back().y);
+    EXPECT_NEAR(250 * NANOS_IN_MILLI, systemCalls->now, 1);
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        EXPECT_NEAR(i * 7812500.0, positions[i].nanos, 1);
+    }
+}
+
+TEST(PacingTest, emissionRateStepsLandOnTicks)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    // 50 ms at 144 Hz is 7.2 ticks, so 8 steps a tick apart rather than 8 steps of 6.25 ms
+    auto nature = NewPacingNature(systemCalls, 50);
+    nature.emissionRateHz = 144;
+    Move(nature, 400, 300);
+
+    auto &positions = systemCalls->positions;
+    ASSERT_EQ(8u, positions.size());
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        EXPECT_NEAR(i * 1.0e9 / 144, positions[i].nanos, 1);
+    }
+    // the last step is cut short and ends with the movement
+    EXPECT_EQ(50 * NANOS_IN_MILLI, systemCalls->now);
+    EXPECT_EQ(400, positions.back().x);
+    EXPECT_EQ(300, positions.back().y);
+}
+
+TEST(PacingTest, lateWakeUpsDoNotAccumulate)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    systemCalls->wakeUpLatency = 700000;
+    systemCalls->setPositionNanos = 150000;
+    auto nature = NewPacingNature(systemCalls, 250);
+    Move(nature, 400, 300);
+
+    auto &positions = systemCalls->positions;
+    ASSERT_EQ(32u, positions.size());
+    const double stepTime = 7812500.0;
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        EXPECT_GE(positions[i].nanos, i * stepTime - 1);
+        EXPECT_LE(positions[i].nanos, i * stepTime + systemCalls->wakeUpLatency + 1);
+    }
+    // within one step of the planned time, relative waits would be 32 * 0.85 ms late
+    EXPECT_LE(systemCalls->now, 250 * NANOS_IN_MILLI + stepTime);
+}
+
+TEST(PacingTest, dropsLateStepsToKeepMovementTime)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    // a loaded machine, setting a position takes longer than a step
+    systemCalls->wakeUpLatency = NANOS_IN_MILLI;
+    systemCalls->setPositionNanos = 12 * NANOS_IN_MILLI;
+    auto nature = NewPacingNature(systemCalls, 250);
+    nature.dropLateSteps = true;
+    nature.stats = std::make_shared<PlaybackStats>();
+    Move(nature, 400, 300);
+
+    auto &positions = systemCalls->positions;
+    auto &stats = *nature.stats;
+    EXPECT_EQ(32u, stats.emittedSteps + stats.droppedSteps);
+    EXPECT_EQ(positions.size(), stats.emittedSteps);
+    EXPECT_GT(stats.droppedSteps, 0u);
+    EXPECT_EQ(400, positions.back().x);
+    EXPECT_EQ(300, positions.back().y);
+    // ends within one step and one slow position update of the planned time, playing every step takes 384 ms
+    EXPECT_LE(systemCalls->now, 250 * NANOS_IN_MILLI + 7812500 + systemCalls->setPositionNanos);
+}
+
+TEST(PacingTest, keepsEveryStepByDefault)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    systemCalls->wakeUpLatency = NANOS_IN_MILLI;
+    systemCalls->setPositionNanos = 12 * NANOS_IN_MILLI;
+    auto nature = NewPacingNature(systemCalls, 250);
+    nature.stats = std::make_shared<PlaybackStats>();
+    Move(nature, 400, 300);
+
+    EXPECT_EQ(32u, systemCalls->positions.size());
+    EXPECT_EQ(32u, nature.stats->emittedSteps);
+    EXPECT_EQ(0u, nature.stats->droppedSteps);
+    // the movement takes as long as setting every position
+    EXPECT_GE(systemCalls->now, 32 * systemCalls->setPositionNanos);
+}
+
+TEST(PacingTest, recordsTimingStats)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    systemCalls->wakeUpLatency = 300000;
+    systemCalls->setPositionNanos = 50000;
+    auto nature = NewPacingNature(systemCalls, 250);
+    nature.stats = std::make_shared<PlaybackStats>();
+    Move(nature, 400, 300);
+
+    auto &stats = *nature.stats;
+    EXPECT_EQ(32u, stats.emittedSteps);
+    EXPECT_EQ(32u, stats.stepLateness.count());
+    // the first step is on time, every other one wakes up late
+    EXPECT_EQ(300000u, stats.stepLateness.max());
+    EXPECT_EQ(300000u, stats.stepLateness.p50());
+    EXPECT_EQ(32u, stats.oversleep.count());
+    EXPECT_EQ(300000u, stats.oversleep.p99());
+    EXPECT_EQ(32u, stats.setMousePositionTime.count());
+    EXPECT_EQ(50000u, stats.setMousePositionTime.max());
+    // read once before planning and once to verify the endpoint
+    EXPECT_EQ(2u, stats.getMousePositionTime.count());
+    EXPECT_EQ(1u, stats.planningTime.count());
+    EXPECT_EQ(1u, stats.timeToFirstStep.count());
+    EXPECT_EQ(250 * NANOS_IN_MILLI, stats.plannedNanos);
+    EXPECT_EQ(250 * NANOS_IN_MILLI + systemCalls->wakeUpLatency, stats.actualNanos);
+}
+
+TEST(PacingTest, reportsRealtimeSettingsInStats)
+{
+    auto systemCalls = std::make_shared<VirtualClockSystemCalls>();
+    auto nature = NewPacingNature(systemCalls, 250);
+    nature.stats = std::make_shared<PlaybackStats>();
+    // no such cpu, pinning fails and the move plays back without it
+    nature.realtime.cpu = 1 << 20;
+    Move(nature, 400, 300);
+
+    EXPECT_EQ(32u, systemCalls->positions.size());
+    EXPECT_FALSE(nature.stats->realtime.pinned);
+    EXPECT_EQ(1u, nature.stats->realtime.failures);
+}
+
+TEST(PacingTest, millisecondSystemCallsStillWork)
+{
+    auto systemCalls = std::make_shared<MockSystemCalls>(800, 500);
+    auto nature = NewPacingNature(systemCalls, 250);
+    Move(nature, 400, 300);
+    EXPECT_EQ(400, systemCalls->getMousePosition().x);
+    EXPECT_EQ(300, systemCalls->getMousePosition().y);
+}
+
+TEST(PacingTest, steadyClockSleepsPrecisely)
+{
+    for (time_type nanos : {100000, 1500000, 3000000})
+    {
+        auto start = DefaultProvider::SteadyClock::Nanos();
+        DefaultProvider::SteadyClock::SleepNanos(nanos);
+        auto slept = DefaultProvider::SteadyClock::Nanos() - start;
+        EXPECT_GE(slept, nanos);
+        // generous, the machine running the tests may be busy
+        EXPECT_LT(slept, nanos + 20 * NANOS_IN_MILLI);
+    }
+}
+
+TEST(PacingTest, steadyClockSleepsUntilDeadline)
+{
+    auto start = DefaultProvider::SteadyClock::Nanos();
+    for (int i = 1; i <= 5; i++)
+    {
+        auto deadline = start + i * NANOS_IN_MILLI;
+        DefaultProvider::SteadyClock::SleepUntilNanos(deadline);
+        EXPECT_GE(DefaultProvider::SteadyClock::Nanos(), deadline);
+    }
+    // a deadline in the past returns immediately
+    DefaultProvider::SteadyClock::SleepUntilNanos(start);
+    EXPECT_LT(DefaultProvider::SteadyClock::Nanos() - start, 5 * NANOS_IN_MILLI + 20 * NANOS_IN_MILLI);
+}
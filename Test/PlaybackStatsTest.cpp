@@ -0,0 +1,54 @@
+#include "gtest/gtest.h"
+#include "PlaybackStats.h"
+
+using namespace NaturalMouseMotion;
+
+TEST(PlaybackStatsTest, emptyHistogram)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.p50());
+    EXPECT_EQ(0u, histogram.max());
+    EXPECT_EQ(0.0, histogram.mean());
+}
+
+TEST(PlaybackStatsTest, bucketsCoverEveryValue)
+{
+    EXPECT_EQ(0u, LatencyHistogram::lowerBoundOf(0));
+    for (size_t i = 1; i < LatencyHistogram::BUCKETS; i++)
+    {
+        EXPECT_EQ(LatencyHistogram::upperBoundOf(i - 1) + 1, LatencyHistogram::lowerBoundOf(i));
+        EXPECT_LE(LatencyHistogram::lowerBoundOf(i), LatencyHistogram::upperBoundOf(i));
+    }
+    EXPECT_EQ(UINT64_MAX, LatencyHistogram::upperBoundOf(LatencyHistogram::BUCKETS - 1));
+}
+
+TEST(PlaybackStatsTest, percentilesAreWithinBucketPrecision)
+{
+    LatencyHistogram histogram;
+    for (int64_t i = 1; i <= 1000; i++)
+    {
+        histogram.add(i * 1000);
+    }
+    histogram.add(-5);
+
+    EXPECT_EQ(1001u, histogram.count());
+    EXPECT_EQ(1000000u, histogram.max());
+    EXPECT_EQ(500500000u, histogram.total());
+    EXPECT_NEAR(500000, histogram.p50(), 500000 * 0.25);
+    EXPECT_NEAR(990000, histogram.p99(), 990000 * 0.25);
+    EXPECT_GE(histogram.p50(), 500000u);
+    EXPECT_EQ(1000000u, histogram.percentile(1.0));
+    EXPECT_EQ(0u, histogram.percentile(0.0005));
+}
+
+TEST(PlaybackStatsTest, smallValuesAreExact)
+{
+    LatencyHistogram histogram;
+    histogram.add(1);
+    histogram.add(2);
+    histogram.add(3);
+    EXPECT_EQ(2u, histogram.p50());
+    EXPECT_EQ(3u, histogram.p99());
+    EXPECT_EQ(2.0, histogram.mean());
+}
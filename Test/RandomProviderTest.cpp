@@ -0,0 +1,184 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include "DefaultProvider.h"
+#include "MovementFactory.h"
+#include "StepKernel.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+TEST(RandomProviderTest, fastProviderIsInRange)
+{
+    DefaultProvider::FastRandomProvider random(42);
+    double sum = 0;
+    for (int i = 0; i < 10000; i++)
+    {
+        auto v = random();
+        EXPECT_TRUE(v >= 0.0 && v < 1.0);
+        sum += v;
+    }
+    EXPECT_NEAR(0.5, sum / 10000, 0.02);
+}
+
+TEST(RandomProviderTest, fastProviderFillMatchesSingleDraws)
+{
+    DefaultProvider::FastRandomProvider single(7);
+    DefaultProvider::FastRandomProvider bulk(7);
+    double values[64];
+    bulk.fill(values, 64);
+    for (auto v : values)
+    {
+        EXPECT_EQ(single(), v);
+    }
+}
+
+TEST(RandomProviderTest, streamFillUsesGeneratorFill)
+{
+    auto fast = RandomStream{DefaultProvider::FastRandomProvider(7)};
+    DefaultProvider::FastRandomProvider reference(7);
+    double values[3];
+    fast.fill(values, 3);
+    for (auto v : values)
+    {
+        EXPECT_EQ(reference(), v);
+    }
+    EXPECT_EQ(reference(), fast());
+}
+
+TEST(RandomProviderTest, streamFillFallsBackToSingleDraws)
+{
+    auto random = RandomStream{MockRandomProvider({0.1, 0.2, 0.3})};
+    double values[4];
+    random.fill(values, 4);
+    EXPECT_EQ(0.1, values[0]);
+    EXPECT_EQ(0.2, values[1]);
+    EXPECT_EQ(0.3, values[2]);
+    EXPECT_EQ(0.1, values[3]);
+    EXPECT_EQ(0.2, random());
+}
+
+TEST(RandomProviderTest, noiseOnlyDrawsItsOffsetWhenThereIsNoise)
+{
+    DefaultProvider::DefaultNoiseProvider noise;
+    // 0.9 is above any noisiness, so no noise and only the gate is drawn
+    auto random = RandomStream{MockRandomProvider({0.9, 0.0, 0.25, 0.75})};
+    auto offset = noise(random, 1, 1);
+    EXPECT_EQ(0.0, offset.x);
+    EXPECT_EQ(0.0, offset.y);
+    // 0.0 passes the gate, the next two draws are the offset
+    offset = noise(random, 1, 1);
+    EXPECT_LT(offset.x, 0.0);
+    EXPECT_GT(offset.y, 0.0);
+    EXPECT_EQ(0.9, random());
+}
+
+TEST(RandomProviderTest, counterProviderMatchesPhiloxKnownAnswer)
+{
+    // Philox4x32-10 of counter 0 and key 0 is {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}
+    DefaultProvider::CounterRandomProvider random(0);
+    EXPECT_EQ(((0x6627e8d5ULL << 32 | 0xe169c58dULL) >> 11) / 9007199254740992.0, random());
+    EXPECT_EQ(((0xbc57ac4cULL << 32 | 0x9b00dbd8ULL) >> 11) / 9007199254740992.0, random());
+}
+
+TEST(RandomProviderTest, counterProviderSeeksToAnyDraw)
+{
+    DefaultProvider::CounterRandomProvider sequential(99, 5);
+    std::vector<double> values;
+    for (int i = 0; i < 9; i++)
+    {
+        values.push_back(sequential());
+    }
+    EXPECT_EQ(9u, sequential.getDraw());
+
+    DefaultProvider::CounterRandomProvider random(99);
+    for (int i = 8; i >= 0; i--)
+    {
+        random.seek(5, i);
+        EXPECT_EQ(values[i], random());
+    }
+
+    random.seek(6);
+    EXPECT_NE(values[0], random());
+    DefaultProvider::CounterRandomProvider otherSeed(100, 5);
+    EXPECT_NE(values[0], otherSeed());
+}
+
+TEST(RandomProviderTest, streamTargetReturnsGenerator)
+{
+    auto random = RandomStream{DefaultProvider::CounterRandomProvider(1, 2)};
+    auto copy = random;
+    ASSERT_NE(nullptr, copy.target<DefaultProvider::CounterRandomProvider>());
+    EXPECT_EQ(2u, copy.target<DefaultProvider::CounterRandomProvider>()->getStream());
+    EXPECT_EQ(nullptr, random.target<DefaultProvider::FastRandomProvider>());
+
+    random();
+    EXPECT_EQ(1u, copy.target<DefaultProvider::CounterRandomProvider>()->getDraw());
+}
+
+static MotionNature NewCounterNature(uint64_t seed)
+{
+    auto nature = NewTestNature(std::make_shared<MockSystemCalls>(500, 500), RandomStream{DefaultProvider::CounterRandomProvider(seed)});
+    nature.overshootManager = std::make_shared<DefaultProvider::DefaultOvershootManager>(nature.random);
+    nature.getFlowWithTime = GetFlowWithTimeFunc{DefaultProvider::DefaultSpeedManager(
+        {
+            Flow(FlowTemplates::variatingFlow()),
+            Flow(FlowTemplates::interruptedFlow()),
+            Flow(FlowTemplates::jaggedFlow()),
+            Flow(FlowTemplates::stoppingFlow()),
+        },
+        nature.random)};
+    return nature;
+}
+
+// Whole trajectory from (10, 480) to (450, 20) of move moveIndex, including overshoots
+static std::vector<Point<int>> trajectory(MotionNature &nature, uint64_t moveIndex)
+{
+    nature.random.target<DefaultProvider::CounterRandomProvider>()->seek(moveIndex);
+    std::vector<Point<int>> result;
+    Point<int> position{10, 480};
+    MovementFactory factory(nature, 450, 20);
+    MovementSteps steps;
+    for (auto &movement : factory.createMovements(position))
+    {
+        StepKernel::Plan(nature, movement, position, {500, 500}, steps);
+        for (int i = 0; i < steps.steps; i++)
+        {
+            result.push_back({steps.x[i], steps.y[i]});
+        }
+        if (!result.empty())
+        {
+            position = result.back();
+        }
+    }
+    return result;
+}
+
+static void expectSameTrajectory(const std::vector<Point<int>> &expected, const std::vector<Point<int>> &actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(expected[i].x, actual[i].x);
+        EXPECT_EQ(expected[i].y, actual[i].y);
+    }
+}
+
+TEST(RandomProviderTest, counterTrajectoryDoesNotDependOnOrder)
+{
+    auto first = NewCounterNature(1234);
+    auto millionthFirst = trajectory(first, 1000000);
+    auto zerothLast = trajectory(first, 0);
+
+    auto last = NewCounterNature(1234);
+    auto zerothFirst = trajectory(last, 0);
+    for (uint64_t i = 1; i < 20; i++)
+    {
+        trajectory(last, i);
+    }
+    auto millionthLast = trajectory(last, 1000000);
+
+    ASSERT_FALSE(millionthFirst.empty());
+    expectSameTrajectory(millionthFirst, millionthLast);
+    expectSameTrajectory(zerothFirst, zerothLast);
+    EXPECT_EQ(450, millionthFirst.back().x);
+    EXPECT_EQ(20, millionthFirst.back().y);
+}
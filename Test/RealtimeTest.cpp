@@ -0,0 +1,116 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include "Realtime.h"
+
+#ifdef __linux__
+
+using namespace NaturalMouseMotion;
+
+struct ThreadSettings
+{
+    int policy;
+    int priority;
+    cpu_set_t affinity;
+    int timerSlack;
+
+    static ThreadSettings Current()
+    {
+        ThreadSettings settings;
+        sched_param param;
+        pthread_getschedparam(pthread_self(), &settings.policy, &param);
+        settings.priority = param.sched_priority;
+        pthread_getaffinity_np(pthread_self(), sizeof(settings.affinity), &settings.affinity);
+        settings.timerSlack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+        return settings;
+    }
+
+    bool operator==(const ThreadSettings &other) const
+    {
+        return policy == other.policy && priority == other.priority && CPU_EQUAL(&affinity, &other.affinity) && timerSlack == other.timerSlack;
+    }
+};
+
+static RealtimeConfig EverySetting()
+{
+    RealtimeConfig config;
+    config.scheduling = RealtimeConfig::Scheduling::Fifo;
+    config.priority = 10;
+    config.cpu = sched_getcpu();
+    config.lockMemory = true;
+    config.lockedSteps = 256;
+    config.minimalTimerSlack = true;
+    return config;
+}
+
+TEST(RealtimeTest, disabledConfigChangesNothing)
+{
+    auto before = ThreadSettings::Current();
+    MovementSteps steps;
+    RealtimeStatus status;
+    status.failures = 3;
+    {
+        RealtimeScope scope(RealtimeConfig{}, steps, &status, nullptr);
+        EXPECT_TRUE(before == ThreadSettings::Current());
+    }
+    EXPECT_EQ(3u, status.failures);
+    EXPECT_FALSE(status.scheduling || status.pinned || status.memoryLocked || status.timerSlack);
+    EXPECT_EQ(0, steps.capacity());
+}
+
+TEST(RealtimeTest, appliesWhatIsPermittedAndRestoresAfter)
+{
+    auto before = ThreadSettings::Current();
+    auto config = EverySetting();
+    MovementSteps steps;
+    RealtimeStatus status;
+    std::vector<std::string> logged;
+    LoggerPrinterFunc printer = [&logged](const std::string str) { logged.push_back(str); };
+    {
+        RealtimeScope scope(config, steps, &status, printer);
+        auto during = ThreadSettings::Current();
+
+        // settings either apply or are reported, never both or neither
+        int applied = status.scheduling + status.pinned + status.memoryLocked + status.timerSlack;
+        EXPECT_EQ(4u, applied + status.failures);
+        EXPECT_EQ(status.failures, logged.size());
+        EXPECT_EQ(status.scheduling, during.policy == SCHED_FIFO);
+        if (status.pinned)
+        {
+            EXPECT_EQ(1, CPU_COUNT(&during.affinity));
+            EXPECT_TRUE(CPU_ISSET(config.cpu, &during.affinity));
+        }
+        if (status.timerSlack)
+        {
+            // real-time threads report no slack at all
+            EXPECT_LE(during.timerSlack, 1);
+        }
+        // locked buffers can't grow out of the locked memory, plans are limited to them
+        EXPECT_EQ(status.memoryLocked ? 256 : 0, steps.capacity());
+        if (status.memoryLocked)
+        {
+            EXPECT_EQ(256, steps.maxSteps());
+            EXPECT_THROW(steps.resize(257), std::length_error);
+        }
+    }
+    EXPECT_TRUE(before == ThreadSettings::Current());
+    EXPECT_EQ(0, steps.capacity());
+}
+
+TEST(RealtimeTest, reportsFailuresAndKeepsCounting)
+{
+    RealtimeConfig config;
+    // no such cpu, always fails
+    config.cpu = CPU_SETSIZE;
+    MovementSteps steps;
+    RealtimeStatus status;
+    {
+        RealtimeScope scope(config, steps, &status, nullptr);
+    }
+    {
+        RealtimeScope scope(config, steps, &status, nullptr);
+    }
+    EXPECT_FALSE(status.pinned);
+    EXPECT_EQ(2u, status.failures);
+    EXPECT_EQ(EINVAL, status.lastError);
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include <vector>
+#include "NaturalMouseMotion.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+// 800x500 monitor with a 600x300 one to the right of it, 100 pixels lower
+static ScreenLayout NewTwoMonitorLayout()
+{
+    return ScreenLayout({{0, 0, 800, 500}, {800, 100, 600, 300}});
+}
+
+struct TwoMonitorSystemCalls : public VirtualClockSystemCalls
+{
+    std::shared_ptr<const ScreenLayout> layout{std::make_shared<const ScreenLayout>(NewTwoMonitorLayout())};
+
+    Dimension getScreenSize() override
+    {
+        return {1400, 500};
+    }
+    std::shared_ptr<const ScreenLayout> getScreenLayout() override
+    {
+        return layout;
+    }
+};
+
+TEST(ScreenLayoutTest, singleMonitorClampsLikeScreenSize)
+{
+    ScreenLayout layout(Dimension{800, 500});
+    EXPECT_TRUE(layout.isRectangular());
+    EXPECT_EQ(1u, layout.getMonitors().size());
+    EXPECT_EQ(0, layout.monitorAt({0, 0}));
+    EXPECT_EQ(0, layout.monitorAt({799, 499}));
+    EXPECT_EQ(-1, layout.monitorAt({800, 499}));
+    EXPECT_EQ(-1, layout.monitorAt({-1, 0}));
+
+    auto clamped = layout.clamp({-5, 900});
+    EXPECT_EQ(0, clamped.x);
+    EXPECT_EQ(499, clamped.y);
+    clamped = layout.clamp({1000, 20});
+    EXPECT_EQ(799, clamped.x);
+    EXPECT_EQ(20, clamped.y);
+}
+
+TEST(ScreenLayoutTest, emptyLayoutClampsToOrigin)
+{
+    ScreenLayout layout;
+    EXPECT_TRUE(layout.getMonitors().empty());
+    EXPECT_EQ(-1, layout.monitorAt({0, 0}));
+    auto clamped = layout.clamp({100, 100});
+    EXPECT_EQ(0, clamped.x);
+    EXPECT_EQ(0, clamped.y);
+}
+
+TEST(ScreenLayoutTest, findsMonitorsAndDeadZones)
+{
+    auto layout = NewTwoMonitorLayout();
+    EXPECT_FALSE(layout.isRectangular());
+    EXPECT_EQ(0, layout.getBounds().x);
+    EXPECT_EQ(0, layout.getBounds().y);
+    EXPECT_EQ(1400, layout.getBounds().width);
+    EXPECT_EQ(500, layout.getBounds().height);
+
+    EXPECT_EQ(0, layout.monitorAt({799, 450}));
+    EXPECT_EQ(1, layout.monitorAt({800, 100}));
+    EXPECT_EQ(1, layout.monitorAt({1399, 399}));
+    // above and below the right monitor
+    EXPECT_EQ(-1, layout.monitorAt({800, 99}));
+    EXPECT_EQ(-1, layout.monitorAt({1000, 400}));
+    EXPECT_FALSE(layout.contains({1300, 450}));
+    EXPECT_TRUE(layout.contains({1300, 350}));
+}
+
+TEST(ScreenLayoutTest, clampsToNearestMonitor)
+{
+    auto layout = NewTwoMonitorLayout();
+    auto clamped = layout.clamp({1300, 450});
+    EXPECT_EQ(1300, clamped.x);
+    EXPECT_EQ(399, clamped.y);
+    clamped = layout.clamp({810, 10});
+    EXPECT_EQ(799, clamped.x);
+    EXPECT_EQ(10, clamped.y);
+    clamped = layout.clamp({2000, 250});
+    EXPECT_EQ(1399, clamped.x);
+    EXPECT_EQ(250, clamped.y);
+    clamped = layout.clamp({1300, 350});
+    EXPECT_EQ(1300, clamped.x);
+    EXPECT_EQ(350, clamped.y);
+}
+
+TEST(ScreenLayoutTest, tiledMonitorsAreRectangular)
+{
+    ScreenLayout layout({{0, 0, 1920, 1080}, {1920, 0, 1920, 1080}, {0, 1080, 3840, 1080}});
+    EXPECT_TRUE(layout.isRectangular());
+    EXPECT_EQ(1, layout.monitorAt({1920, 1079}));
+    EXPECT_EQ(2, layout.monitorAt({3839, 1080}));
+}
+
+TEST(ScreenLayoutTest, overlappingMonitorsBelongToTheFirst)
+{
+    // a mirrored monitor inside a larger one, and an empty one that is left out
+    ScreenLayout layout({{100, 100, 800, 600}, {0, 0, 1920, 1080}, {0, 0, 0, 0}});
+    EXPECT_EQ(2u, layout.getMonitors().size());
+    EXPECT_TRUE(layout.isRectangular());
+    EXPECT_EQ(0, layout.monitorAt({100, 100}));
+    EXPECT_EQ(1, layout.monitorAt({99, 100}));
+    EXPECT_EQ(1, layout.monitorAt({900, 700}));
+}
+
+TEST(ScreenLayoutTest, heldLayoutsSurviveScreenChanges)
+{
+    struct ResizingSystemCalls : public VirtualClockSystemCalls
+    {
+        Dimension size{800, 500};
+
+        Dimension getScreenSize() override
+        {
+            return size;
+        }
+    } systemCalls;
+
+    auto held = systemCalls.getScreenLayout();
+    systemCalls.size = {1024, 768};
+    auto current = systemCalls.getScreenLayout();
+    systemCalls.getScreenSize();
+    EXPECT_EQ(800, held->getBounds().width);
+    EXPECT_EQ(500, held->getBounds().height);
+    EXPECT_EQ(1024, current->getBounds().width);
+    EXPECT_EQ(768, current->getBounds().height);
+}
+
+TEST(ScreenLayoutTest, moveReachesEveryMonitorAndAvoidsDeadZones)
+{
+    auto systemCalls = std::make_shared<TwoMonitorSystemCalls>();
+    auto nature = NewTestNature(systemCalls, RandomStream{MockRandomProvider({0.9, 0.1, 0.7, 0.3, 0.5})});
+    SetOvershoots(nature, 3, RandomStream{MockRandomProvider({0.95, 0.05, 0.9})});
+
+    // the right monitor, past the bottom of the left one would be a dead zone on the way
+    Move(nature, 1300, 350);
+    EXPECT_EQ(1300, systemCalls->positions.back().x);
+    EXPECT_EQ(350, systemCalls->positions.back().y);
+
+    // below the right monitor, ends on its nearest pixel
+    Move(nature, 1300, 450);
+    EXPECT_EQ(1300, systemCalls->positions.back().x);
+    EXPECT_EQ(399, systemCalls->positions.back().y);
+
+    Move(nature, 10, 480);
+    EXPECT_EQ(10, systemCalls->positions.back().x);
+    EXPECT_EQ(480, systemCalls->positions.back().y);
+
+    for (auto &position : systemCalls->positions)
+    {
+        EXPECT_TRUE(systemCalls->layout->contains({position.x, position.y})) << position.x << ", " << position.y;
+    }
+}
@@ -0,0 +1,226 @@
+#include "gtest/gtest.h" // must be included before X.h in linux so put before DefaultProvider.h - see https://github.com/google/googletest/issues/371
+#include "DefaultProvider.h"
+#include "StepKernel.h"
+#include "MockStructs.h"
+
+using namespace NaturalMouseMotion;
+
+static constexpr double SMALL_DELTA = 10e-6;
+static constexpr int SCREEN_WIDTH = 800;
+static constexpr int SCREEN_HEIGHT = 500;
+
+static MotionNature NewKernelNature()
+{
+    return NewTestNature(nullptr, RandomStream{MockRandomProvider({0.9, 0.05, 0.3, 0.01, 0.7, 0.5, 0.02, 0.8})});
+}
+
+static int roundTowards(double value, int target)
+{
+    return target > value ? (int)std::ceil(value) : (int)std::floor(value);
+}
+
+// Positions as calculated one step at a time, the way the playback loop used to do it.
+static std::vector<Point<int>> stepByStep(MotionNature &nature, const Movement &movement, Point<int> start)
+{
+    std::vector<Point<int>> result;
+    auto steps = StepKernel::StepsFor(nature, movement);
+    double simulatedMouseX = start.x;
+    double simulatedMouseY = start.y;
+    double deviationMultiplierX = (nature.random() - 0.5) * 2;
+    double deviationMultiplierY = (nature.random() - 0.5) * 2;
+    double completedXDistance = 0;
+    double completedYDistance = 0;
+    double noiseX = 0;
+    double noiseY = 0;
+    for (int i = 0; i < steps; i++)
+    {
+        double timeCompletion = i / (double)steps;
+        double effectFadeStep = std::max(i - (steps - nature.effectFadeSteps) + 1, 0);
+        double effectFadeMultiplier = (nature.effectFadeSteps - effectFadeStep) / nature.effectFadeSteps;
+        double xStepSize = movement.flow->getStepSize(movement.xDistance, steps, timeCompletion);
+        double yStepSize = movement.flow->getStepSize(movement.yDistance, steps, timeCompletion);
+        completedXDistance += xStepSize;
+        completedYDistance += yStepSize;
+        double completion = std::min(1.0, std::hypot(completedXDistance, completedYDistance) / movement.distance);
+        auto noise = nature.getNoise(nature.random, xStepSize, yStepSize);
+        auto deviation = nature.getDeviation(movement.distance, completion);
+        noiseX += noise.y;
+        noiseY += noise.y;
+        simulatedMouseX += xStepSize;
+        simulatedMouseY += yStepSize;
+        auto x = roundTowards(simulatedMouseX + deviation.x * deviationMultiplierX * effectFadeMultiplier + noiseX * effectFadeMultiplier, movement.destX);
+        auto y = roundTowards(simulatedMouseY + deviation.y * deviationMultiplierY * effectFadeMultiplier + noiseY * effectFadeMultiplier, movement.destY);
+        result.push_back({std::max(0, std::min(SCREEN_WIDTH - 1, x)), std::max(0, std::min(SCREEN_HEIGHT - 1, y))});
+    }
+    return result;
+}
+
+static void expectSameAsStepByStep(const Flow &flow, Point<int> start, int destX, int destY, time_type time)
+{
+    int xDistance = destX - start.x;
+    int yDistance = destY - start.y;
+    Movement movement(destX, destY, std::hypot(xDistance, yDistance), xDistance, yDistance, time, &flow);
+
+    auto referenceNature = NewKernelNature();
+    auto expected = stepByStep(referenceNature, movement, start);
+
+    auto nature = NewKernelNature();
+    MovementSteps steps;
+    StepKernel::Plan(nature, movement, start, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+
+    ASSERT_EQ(expected.size(), (size_t)steps.steps);
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(expected[i].x, steps.x[i]);
+        EXPECT_EQ(expected[i].y, steps.y[i]);
+    }
+    if (!expected.empty())
+    {
+        EXPECT_EQ(destX, steps.x.back());
+        EXPECT_EQ(destY, steps.y.back());
+    }
+}
+
+TEST(StepKernelTest, matchesStepByStepCalculation)
+{
+    std::vector<Flow> flows = {
+        Flow(FlowTemplates::variatingFlow()),
+        Flow(FlowTemplates::interruptedFlow()),
+        Flow(FlowTemplates::stoppingFlow()),
+        Flow(FlowTemplates::adjustingFlow()),
+        Flow(FlowTemplates::constantSpeed()),
+    };
+    for (auto &flow : flows)
+    {
+        expectSameAsStepByStep(flow, {10, 20}, 700, 400, 500);
+        expectSameAsStepByStep(flow, {700, 400}, 10, 20, 250);
+        expectSameAsStepByStep(flow, {300, 300}, 305, 290, 1000);
+        expectSameAsStepByStep(flow, {0, 0}, 799, 0, 43);
+    }
+}
+
+TEST(StepKernelTest, effectFadeReachesZeroOnLastStep)
+{
+    Flow flow{FlowTemplates::constantSpeed()};
+    Movement movement(400, 300, 500, 400, 300, 800, &flow);
+    auto nature = NewKernelNature();
+    MovementSteps steps;
+    StepKernel::Plan(nature, movement, {0, 0}, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+
+    ASSERT_EQ(100, steps.steps);
+    EXPECT_NEAR(1.0, steps.effectFade[0], SMALL_DELTA);
+    EXPECT_NEAR(1.0, steps.effectFade[steps.steps - nature.effectFadeSteps - 1], SMALL_DELTA);
+    EXPECT_NEAR(0.0, steps.effectFade[steps.steps - 1], SMALL_DELTA);
+    EXPECT_NEAR(1.0, steps.completion[steps.steps - 1], SMALL_DELTA);
+    EXPECT_NEAR(400.0, steps.simulatedX[steps.steps - 1], SMALL_DELTA);
+    EXPECT_NEAR(300.0, steps.simulatedY[steps.steps - 1], SMALL_DELTA);
+}
+
+TEST(StepKernelTest, zeroDistanceHasNoSteps)
+{
+    Flow flow{FlowTemplates::constantSpeed()};
+    Movement movement(10, 10, 0, 0, 0, 100, &flow);
+    auto nature = NewKernelNature();
+    MovementSteps steps;
+    StepKernel::Plan(nature, movement, {10, 10}, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+    EXPECT_EQ(0, steps.steps);
+}
+
+TEST(StepKernelTest, emissionRatePlansOneStepPerTick)
+{
+    auto nature = NewKernelNature();
+    Flow flow{FlowTemplates::constantSpeed()};
+
+    Movement longMovement(700, 400, 806, 700, 400, 1000, &flow);
+    EXPECT_EQ(125, StepKernel::StepsFor(nature, longMovement));
+    nature.emissionRateHz = 60;
+    EXPECT_EQ(60, StepKernel::StepsFor(nature, longMovement));
+    nature.emissionRateHz = 144;
+    EXPECT_EQ(144, StepKernel::StepsFor(nature, longMovement));
+
+    // fractional ticks get a step of their own
+    Movement shortMovement(40, 30, 50, 40, 30, 50, &flow);
+    nature.emissionRateHz = 144;
+    EXPECT_EQ(8, StepKernel::StepsFor(nature, shortMovement));
+    nature.emissionRateHz = 60;
+    EXPECT_EQ(3, StepKernel::StepsFor(nature, shortMovement));
+
+    // still never more steps than pixels
+    Movement tinyMovement(3, 0, 3, 3, 0, 100, &flow);
+    nature.emissionRateHz = 240;
+    EXPECT_EQ(3, StepKernel::StepsFor(nature, tinyMovement));
+
+    Movement instantMovement(300, 0, 300, 300, 0, 0, &flow);
+    EXPECT_EQ(1, StepKernel::StepsFor(nature, instantMovement));
+}
+
+TEST(StepKernelTest, emissionRateStepsStartOnTicks)
+{
+    auto nature = NewKernelNature();
+    Flow flow{FlowTemplates::constantSpeed()};
+    MovementSteps steps;
+
+    Movement shortMovement(40, 30, 50, 40, 30, 50, &flow);
+    nature.emissionRateHz = 144;
+    StepKernel::Plan(nature, shortMovement, {0, 0}, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+    ASSERT_EQ(8, steps.steps);
+    EXPECT_NEAR(1.0e9 / 144, steps.stepNanos, SMALL_DELTA);
+    EXPECT_NEAR(7 * 1.0e9 / 144, steps.startOf(7), SMALL_DELTA);
+    EXPECT_EQ(50.0 * NANOS_IN_MILLI, steps.startOf(8));
+    // positions are those of the tick times, the last one of the end of the movement
+    EXPECT_NEAR(7 * 1.0e9 / 144 / (50.0 * NANOS_IN_MILLI), steps.coveredFraction[7], SMALL_DELTA);
+    EXPECT_EQ(1.0, steps.coveredFraction[8]);
+
+    // more ticks than pixels, every step spans the same number of ticks
+    Movement tinyMovement(3, 0, 3, 3, 0, 100, &flow);
+    nature.emissionRateHz = 240;
+    StepKernel::Plan(nature, tinyMovement, {0, 0}, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+    ASSERT_EQ(3, steps.steps);
+    EXPECT_NEAR(8 * 1.0e9 / 240, steps.stepNanos, SMALL_DELTA);
+
+    // without a rate steps divide the movement time equally
+    nature.emissionRateHz = 0;
+    StepKernel::Plan(nature, shortMovement, {0, 0}, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+    EXPECT_NEAR(50.0 * NANOS_IN_MILLI / steps.steps, steps.stepNanos, SMALL_DELTA);
+}
+
+TEST(StepKernelTest, emissionRatePlanEndsAtDestination)
+{
+    auto nature = NewKernelNature();
+    nature.emissionRateHz = 60;
+    Flow flow{FlowTemplates::variatingFlow()};
+    Movement movement(700, 400, std::hypot(690, 380), 690, 380, 500, &flow);
+    MovementSteps steps;
+    StepKernel::Plan(nature, movement, {10, 20}, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+
+    ASSERT_EQ(30, steps.steps);
+    EXPECT_EQ(700, steps.x.back());
+    EXPECT_EQ(400, steps.y.back());
+}
+
+TEST(StepKernelTest, placedStepsLimitThePlan)
+{
+    auto nature = NewKernelNature();
+    Flow flow{FlowTemplates::constantSpeed()};
+    Movement movement(700, 400, 806, 700, 400, 1000, &flow);
+    std::vector<double> memory(MovementSteps::BytesFor(16) / sizeof(double) + 1);
+    MovementSteps steps;
+    steps.place(memory.data(), 16);
+
+    StepKernel::Plan(nature, movement, {0, 0}, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+    ASSERT_EQ(16, steps.steps);
+    EXPECT_NEAR(1000.0 * NANOS_IN_MILLI / 16, steps.stepNanos, SMALL_DELTA);
+    EXPECT_EQ(700, steps.x.back());
+    EXPECT_EQ(400, steps.y.back());
+
+    // 144 ticks over at most 16 steps, 9 ticks each
+    nature.emissionRateHz = 144;
+    StepKernel::Plan(nature, movement, {0, 0}, {SCREEN_WIDTH, SCREEN_HEIGHT}, steps);
+    ASSERT_EQ(16, steps.steps);
+    EXPECT_NEAR(9 * 1.0e9 / 144, steps.stepNanos, SMALL_DELTA);
+    EXPECT_EQ(700, steps.x.back());
+
+    EXPECT_THROW(steps.resize(17), std::length_error);
+    steps.unplace();
+    EXPECT_EQ(0, steps.capacity());
+}